@@ -0,0 +1,97 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "PwmComplementary.h"
+#include "PwmDoubleGroup.h"
+#include "mbed_assert.h"
+
+namespace mbed {
+
+PwmComplementary::PwmComplementary( PwmDoubleOut& high, PwmDoubleOut& low,
+                                    int dead_time ) :
+	_high( high ), _low( low ), _duty( 0 ), _duty_period( 0 ), _dead( 1 ) {
+	// adjacent channels share a match register: the high fall edge would
+	// be the low rise edge, with no dead time between them
+	int apart = _high.channel() - _low.channel();
+	MBED_ASSERT( apart >= 2 || apart <= -2 );
+	( void )apart;
+	set_dead_time( dead_time );
+}
+
+void PwmComplementary::set_duty_cycle( int value ) {
+	_duty = ( value < 0 ) ? 0 : ( uint32_t )value;
+	_duty_period = pwmdoubleout_match[0];
+	update();
+}
+
+void PwmComplementary::write_q16( uint32_t fraction ) {
+	if ( fraction > PWMDOUBLEOUT_Q16_ONE ) {
+		fraction = PWMDOUBLEOUT_Q16_ONE;
+	}
+	set_duty_cycle( ( int )( ( ( uint64_t )pwmdoubleout_match[0] * fraction ) >> 16 ) );
+}
+
+void PwmComplementary::set_dead_time( int ticks ) {
+	_dead = ( ticks < 1 ) ? 1 : ( uint32_t )ticks;
+	update();
+}
+
+void PwmComplementary::set_dead_time_ns( int ns ) {
+	uint32_t ticks = 0;
+	if ( ns > 0 ) {
+		ticks = ( uint32_t )( ( ( uint64_t )ns * pwmdoubleout_clock_hz() + 999999999 ) / 1000000000 );
+	}
+	set_dead_time( ticks );
+}
+
+void PwmComplementary::set_freq( int value ) {
+	PwmDoubleGroup group;
+	_high.set_freq( value );
+	// the on time stays in ticks
+	_duty_period = pwmdoubleout_match[0];
+	update();
+}
+
+void PwmComplementary::retune( int value ) {
+	// the outputs' own rescale is replaced, in the same group, by edges
+	// derived from the on time as set and the dead time in ticks
+	PwmDoubleGroup group;
+	_high.retune( value );
+	update();
+}
+
+void PwmComplementary::update() {
+	uint32_t period = pwmdoubleout_match[0];
+	uint32_t duty = _duty;
+	uint32_t on = 0;
+	uint32_t off = 0;
+	if ( _duty_period > 0 && _duty_period != period ) {
+		// scaled once from the value as set, whatever retunes came between
+		duty = ( uint32_t )( ( uint64_t )_duty * period / _duty_period );
+	}
+	if ( period > 2 * _dead ) {
+		// clamp so that both pulses fit with a dead time on each side
+		uint32_t span = period - 2 * _dead;
+		on = ( duty > span ) ? span : duty;
+		off = span - on;
+	}
+
+	// both channels latch on the same period start
+	PwmDoubleGroup group;
+	_high.set_edges( 0, on );
+	_low.set_edges( on + _dead, off );
+}
+
+} // namespace mbed
@@ -0,0 +1,110 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_PWMCOMPLEMENTARY_H
+#define MBED_PWMCOMPLEMENTARY_H
+
+#include "platform.h"
+
+#if DEVICE_PWMDOUBLEOUT
+#include "PwmDoubleOut.h"
+
+namespace mbed {
+
+/** A complementary high-side/low-side output pair with dead time
+ *
+ * The high output is on from the period start for the duty cycle. The
+ * low output is on for the rest of the period, shortened by the dead time
+ * at both ends, so the gap before the next high pulse spans the MR0
+ * wraparound. The duty cycle is clamped so that neither pulse goes
+ * negative. The edges of both channels are latched in one PwmDoubleGroup.
+ *
+ * Neither pulse ever straddles the period start. An output that is still
+ * set when new match values latch stays set until its new fall edge, so a
+ * wrapping pulse could overlap the other output for one period after a
+ * change; anchoring both pulses inside the period rules that out.
+ *
+ * Example
+ * @code
+ * PwmDoubleOut hs( p25 ), ls( p23 );
+ * PwmComplementary bridge( hs, ls );
+ *
+ * bridge.set_freq( 192 );
+ * bridge.set_dead_time_ns( 100 );
+ * bridge.set_duty_cycle( 96 );
+ * @endcode
+ *
+ * @note
+ *  The dead time is at least one tick: the driver moves a fall edge that
+ *  lands exactly on the period start to tick 1, which would otherwise
+ *  overlap the other output's rise edge.
+ *
+ * @note
+ *  The two outputs must not be adjacent channels (PWM1.n and PWM1.n+1
+ *  share MRn, so the high fall would be the low rise), and the period must
+ *  only be changed through set_freq() or retune() of the pair. A retune(),
+ *  period_us() or freq_khz() of any PwmDoubleOut rescales each edge on its
+ *  own, rounding down, and can close the dead time: on 10 and dead 1 at
+ *  100 ticks put both the high fall and the low rise at 5 of 50. The next
+ *  call on the pair derives both edges again.
+ */
+class PwmComplementary {
+
+public:
+
+	/** Create a complementary pair
+	 *
+	 *  @param high      High-side output
+	 *  @param low       Low-side output
+	 *  @param dead_time Dead time in ticks
+	 */
+	PwmComplementary( PwmDoubleOut& high, PwmDoubleOut& low, int dead_time = 1 );
+
+	/** Set the high-side on time, specified as the register value (int) */
+	void set_duty_cycle( int value );
+
+	/** Set the high-side on time, specified as a Q16 fraction of the period */
+	void write_q16( uint32_t fraction );
+
+	/** Set the dead time inserted before each rise edge, in ticks */
+	void set_dead_time( int ticks );
+
+	/** Set the dead time inserted before each rise edge, in nanoseconds.
+	 *  The value is rounded up to whole ticks. */
+	void set_dead_time_ns( int ns );
+
+	/** Set the PWM period, specified as the MR0 register value (int).
+	 *  The on time and dead time stay in ticks. */
+	void set_freq( int value );
+
+	/** Change the PWM period without resetting the counter. The on time
+	 *  keeps its fraction of the period, the dead time stays in ticks. */
+	void retune( int value );
+
+protected:
+	void update();
+
+	PwmDoubleOut& _high;
+	PwmDoubleOut& _low;
+	uint32_t _duty;
+	uint32_t _duty_period;
+	uint32_t _dead;
+};
+
+} // namespace mbed
+
+#endif
+
+#endif
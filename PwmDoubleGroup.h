@@ -0,0 +1,84 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_PWMDOUBLEGROUP_H
+#define MBED_PWMDOUBLEGROUP_H
+
+#include "platform.h"
+
+#if DEVICE_PWMDOUBLEOUT
+#include "pwmdoubleout_api.h"
+
+namespace mbed {
+
+/** A transaction over the PwmDoubleOut outputs sharing PWM1
+ *
+ * While a group is open every PwmDoubleOut setter only stages its match
+ * registers. commit() (or leaving the scope) stores them and latches all of
+ * them with a single LER write, so every channel switches to the new
+ * configuration on the same period start.
+ *
+ * Example
+ * @code
+ * {
+ *     PwmDoubleGroup group;
+ *     waveB.set_freq( fq );
+ *     waveA.set_duty_cycle( dA );
+ *     waveB.set_dephase( ph );
+ *     waveB.set_duty_cycle( dB );
+ * } // latched together here
+ * @endcode
+ *
+ * @note
+ *  Groups nest; only the outermost commit touches the hardware. Setters
+ *  called from an interrupt while a group is open are staged as well.
+ */
+class PwmDoubleGroup {
+
+public:
+
+	/** Open a group transaction
+	 */
+	PwmDoubleGroup() : _open( true ) {
+		pwmdoubleout_group_begin();
+	}
+
+	/** Commit the transaction if commit() has not been called yet
+	 */
+	~PwmDoubleGroup() {
+		commit();
+	}
+
+	/** Store the staged match registers and latch them with one LER write
+	 */
+	void commit() {
+		if ( _open ) {
+			_open = false;
+			pwmdoubleout_group_commit();
+		}
+	}
+
+private:
+	PwmDoubleGroup( const PwmDoubleGroup& );
+	PwmDoubleGroup& operator= ( const PwmDoubleGroup& );
+
+	bool _open;
+};
+
+} // namespace mbed
+
+#endif
+
+#endif
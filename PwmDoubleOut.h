@@ -82,6 +82,86 @@ public:
 	void set_dephase( int value ) {
 		pwmdoubleout_set_dephase( &_pwm, value );
 	}
+	/** Set the ouput dephase from the PWM1 period interrupt, specified as the register value (int)
+	 *
+	 *  Unlike set_dephase(), the value is stored at once even while the
+	 *  interrupted code holds a PwmDoubleGroup open, and it latches at the
+	 *  next period start.
+	 */
+	void store_dephase( int value ) {
+		pwmdoubleout_store_dephase( &_pwm, value );
+	}
+	/** Set the dephase and the duty-cycle together, both specified as register values (int)
+	 *
+	 *  @param rise  Tick at which the output is set, wrapped into the period
+	 *  @param width Pulse width in ticks; a width of a full period or more keeps the output set
+	 */
+	void set_edges( int rise, int width ) {
+		pwmdoubleout_set_edges( &_pwm, rise, width );
+	}
+	/** Set the dephase and the duty-cycle with sub-tick resolution
+	 *
+	 *  The edges move by one tick in a fraction of the periods so that their
+	 *  average lands between ticks (first order sigma-delta, updated by the
+	 *  period interrupt).
+	 *
+	 *  @param rise  Rise tick << PWMDOUBLEOUT_DITHER_BITS
+	 *  @param width Pulse width in ticks << PWMDOUBLEOUT_DITHER_BITS
+	 *
+	 *  @note
+	 *   Until dither_stop() the other setters must not be used on this output,
+	 *   and values must be given again after the period changes.
+	 *   The PWM1 interrupt has to be taken within one period, so handlers that
+	 *   run longer need a lower priority than PWMDOUBLEOUT_IRQ_PRIORITY; a
+	 *   period it misses repeats the last edges and is made up for next.
+	 */
+	void dither( uint32_t rise, uint32_t width ) {
+		pwmdoubleout_dither( &_pwm, rise, width );
+	}
+	/** Stop dithering, keeping the edges rounded to the nearest tick */
+	void dither_stop() {
+		pwmdoubleout_dither_stop( &_pwm );
+	}
+	/** Emit a counted burst of pulses with the current dephase and width
+	 *
+	 *  The output goes low at the next period start and the first pulse
+	 *  comes one period later. After 'count' pulses the output stays low.
+	 *
+	 *  @param count    Number of pulses, at least 1
+	 *  @param interval Idle periods before the burst repeats, 0 for a single burst
+	 *  @param done     Called from the period interrupt once the last pulse of
+	 *                  each burst is under way, or 0
+	 *  @param id       Passed to done
+	 *  @returns 0 on success, -1 if count is 0 or no interrupt slot is free
+	 *
+	 *  @note
+	 *   Until the burst has ended or burst_stop() is called, the other setters
+	 *   must not be used on this output, nor the period changed.
+	 *   Interrupts taken late mid burst do not change the count; one taken a
+	 *   period late at the last pulse repeats it, and shows in
+	 *   pwmdoubleout_irq_overruns().
+	 */
+	int burst( uint32_t count, uint32_t interval = 0,
+	           pwmdoubleout_irq_handler done = 0, uintptr_t id = 0 ) {
+		return pwmdoubleout_burst( &_pwm, count, interval, done, id );
+	}
+	/** Abort a burst; the output is low from the next period start */
+	void burst_stop() {
+		pwmdoubleout_burst_stop( &_pwm );
+	}
+	/** Return whether a burst is still running or will repeat */
+	bool bursting() {
+		return pwmdoubleout_burst_active( &_pwm ) != 0;
+	}
+	/** Set the ouput dephase, specified as a Q16 fraction of the period
+	 *
+	 *  @param fraction Dephase in 1/65536ths of the period, 0 to 0x10000
+	 *    (PWMDOUBLEOUT_Q16_ONE). Larger values saturate to one full cycle.
+	 *    The match value is computed with an integer multiply and shift.
+	 */
+	void dephase_q16( uint32_t fraction ) {
+		pwmdoubleout_dephase_q16( &_pwm, fraction );
+	}
 
 	/** Set the ouput duty-cycle, specified as the register value (int)
 	 *
@@ -103,6 +183,24 @@ public:
 	void set_duty_cycle( int value ) {
 		pwmdoubleout_set_duty_cycle( &_pwm, value );
 	}
+	/** Set the ouput duty-cycle from the PWM1 period interrupt, specified as the register value (int)
+	 *
+	 *  Unlike set_duty_cycle(), the value is stored at once even while the
+	 *  interrupted code holds a PwmDoubleGroup open, and it latches at the
+	 *  next period start.
+	 */
+	void store_duty_cycle( int value ) {
+		pwmdoubleout_store_duty_cycle( &_pwm, value );
+	}
+	/** Set the ouput duty-cycle, specified as a Q16 fraction of the period
+	 *
+	 *  @param fraction Duty-cycle in 1/65536ths of the period, 0 to 0x10000
+	 *    (PWMDOUBLEOUT_Q16_ONE). Larger values saturate to 100%.
+	 *    The match value is computed with an integer multiply and shift.
+	 */
+	void write_q16( uint32_t fraction ) {
+		pwmdoubleout_write_q16( &_pwm, fraction );
+	}
 
 	/** Return the current output duty-cycle setting, measured as a percentage (float)
 	 *
@@ -118,6 +216,29 @@ public:
 		return pwmdoubleout_read( &_pwm );
 	}
 
+	/** Return the current output duty-cycle setting as a Q16 fraction of the period
+	 *
+	 *  @returns
+	 *    The duty-cycle in 1/65536ths of the period, between 0 and
+	 *    0x10000 (PWMDOUBLEOUT_Q16_ONE), computed without floating point.
+	 */
+	uint32_t read_q16() {
+		return pwmdoubleout_read_q16( &_pwm );
+	}
+	/** Return the PWM1 channel, 2 to 6; channel n rises on MR(n-1) and
+	 *  falls on MRn, so adjacent channels share a match register */
+	int channel() {
+		return _pwm.pwm;
+	}
+	/** Return the pulse width in ticks, as last set */
+	uint32_t read_width() {
+		return pwmdoubleout_width[_pwm.pwm];
+	}
+	/** Return the dephase (rise edge) in ticks, as last set */
+	uint32_t read_dephase() {
+		return pwmdoubleout_match[_pwm.pwm - 1];
+	}
+
 	/** Set the PWM period, specified in seconds (float), keeping the duty cycle the same.
 	 *
 	 *  @note
@@ -144,11 +265,57 @@ public:
 	void freq_khz( int khz ) {
 		pwmdoubleout_freq_khz( &_pwm, khz );
 	}
-	/** Set the PWM frequency, specified in khz (int), keeping the duty cycle the same.
+	/** Set the PWM period, specified as the MR0 register value (int).
+	 *  The channels keep their rise edge and pulse width in ticks, wrapped
+	 *  into the new period.
 	 */
 	void set_freq( int value ) {
 		pwmdoubleout_set_freq( &_pwm, value );
 	}
+	/** Set the PWM period, specified in ticks (int), keeping the duty cycle and
+	 *  dephase of every channel the same.
+	 *
+	 *  @note
+	 *   The counter keeps running: MR0 and the rescaled edges of all channels
+	 *   are latched together at the next period start, so no runt pulse is
+	 *   produced.
+	 */
+	void retune( int value ) {
+		pwmdoubleout_retune( &_pwm, value );
+	}
+	/** Set the PWM period from the PWM1 period interrupt, specified in ticks (int)
+	 *
+	 *  Unlike retune(), MR0 and the rescaled edges are stored at once even
+	 *  while the interrupted code holds a PwmDoubleGroup open.
+	 */
+	void store_retune( int value ) {
+		pwmdoubleout_store_retune( &_pwm, value );
+	}
+	/** Choose the timer clock and period for a frequency
+	 *
+	 *  @param plan      Receives the PCLK divider, prescaler, MR0 and the
+	 *                   achieved frequency and error
+	 *  @param freq_hz   Requested frequency
+	 *  @param min_steps Fewest duty/phase steps per period acceptable
+	 *  @returns 0 on success, -1 if min_steps cannot be reached at freq_hz
+	 */
+	static int plan( pwmdoubleout_plan_t& plan, uint32_t freq_hz, uint32_t min_steps ) {
+		return pwmdoubleout_plan( &plan, freq_hz, min_steps );
+	}
+	/** Switch to a planned clock and period, keeping the duty cycle and
+	 *  dephase of every channel the same.
+	 *
+	 *  @note
+	 *   The counter is restarted, truncating the current period. Do not
+	 *   call this inside a PwmDoubleGroup.
+	 */
+	void apply_plan( const pwmdoubleout_plan_t& plan ) {
+		pwmdoubleout_apply_plan( &plan );
+	}
+	/** Timer ticks per second at the current clock setting */
+	static uint32_t clock_hz() {
+		return pwmdoubleout_clock_hz();
+	}
 
 	/** Set the PWM pulsewidth, specified in seconds (float), keeping the period the same.
 	 */
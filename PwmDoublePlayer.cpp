@@ -0,0 +1,86 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "PwmDoublePlayer.h"
+#include "mbed_assert.h"
+
+namespace mbed {
+
+PwmDoublePlayer::PwmDoublePlayer( PwmDoubleOut& a, PwmDoubleOut& b, PwmDoubleOut& c,
+                                  const uint32_t* table, uint32_t size, uint32_t divider ) :
+	_a( a ), _b( b ), _c( c ), _table( table ), _size( size ),
+	_divider( divider ? divider : 1 ), _count( 0 ), _index( 0 ), _running( false ) {
+	MBED_ASSERT( size > 0 && size % 3 == 0 );
+}
+
+PwmDoublePlayer::~PwmDoublePlayer() {
+	stop();
+}
+
+int PwmDoublePlayer::start() {
+	if ( _running ) {
+		return 0;
+	}
+	_count = 0;
+	if ( pwmdoubleout_irq_attach( &PwmDoublePlayer::irq, ( uintptr_t )this ) < 0 ) {
+		return -1;
+	}
+	_running = true;
+	return 0;
+}
+
+void PwmDoublePlayer::stop() {
+	if ( _running ) {
+		pwmdoubleout_irq_detach( &PwmDoublePlayer::irq, ( uintptr_t )this );
+		_running = false;
+	}
+}
+
+void PwmDoublePlayer::set_divider( uint32_t divider ) {
+	_divider = divider ? divider : 1;
+}
+
+void PwmDoublePlayer::irq( uintptr_t id ) {
+	( ( PwmDoublePlayer* )id )->period();
+}
+
+void PwmDoublePlayer::period() {
+	if ( ++_count < _divider ) {
+		return;
+	}
+	_count = 0;
+
+	uint32_t third = _size / 3;
+	uint32_t b = _index + 2 * third;
+	uint32_t c = _index + third;
+	if ( b >= _size ) {
+		b -= _size;
+	}
+	if ( c >= _size ) {
+		c -= _size;
+	}
+
+	// stored together in this interrupt, all three phases latch on the
+	// same period start; a group open in main would otherwise hold them
+	_a.store_duty_cycle( _table[_index] );
+	_b.store_duty_cycle( _table[b] );
+	_c.store_duty_cycle( _table[c] );
+
+	if ( ++_index == _size ) {
+		_index = 0;
+	}
+}
+
+} // namespace mbed
@@ -0,0 +1,92 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_PWMDOUBLEPLAYER_H
+#define MBED_PWMDOUBLEPLAYER_H
+
+#include "platform.h"
+
+#if DEVICE_PWMDOUBLEOUT
+#include "PwmDoubleOut.h"
+
+namespace mbed {
+
+/** Plays a duty table on three PwmDoubleOut channels 120 degrees apart
+ *
+ * The table holds one cycle of phase A duty values in ticks, typically an
+ * SpwmTable or SvpwmTable. From the PWM1 period interrupt the player
+ * advances one entry every 'divider' periods and stores the three duty
+ * cycles directly, so they latch together at the next period start even
+ * while the main code holds a PwmDoubleGroup open. Phase B is read 2N/3
+ * and phase C N/3 entries ahead. The fundamental frequency is therefore
+ * f_pwm / ( size * divider ).
+ *
+ * Example
+ * @code
+ * typedef SpwmTable<96, 192> Table;
+ * PwmDoubleOut u( p25 ), v( p23 ), w( p21 ); // PWM1.2, PWM1.4, PWM1.6
+ * PwmDoublePlayer player( u, v, w, Table::duty, Table::size, 10 );
+ *
+ * player.start(); // 500 kHz / ( 96 * 10 ) = 520 Hz
+ * @endcode
+ */
+class PwmDoublePlayer {
+
+public:
+
+	/** Create a player
+	 *
+	 *  @param a,b,c   Phase outputs
+	 *  @param table   Duty values in ticks for one cycle
+	 *  @param size    Entries in table, a multiple of three
+	 *  @param divider PWM periods per table entry
+	 */
+	PwmDoublePlayer( PwmDoubleOut& a, PwmDoubleOut& b, PwmDoubleOut& c,
+	                 const uint32_t* table, uint32_t size, uint32_t divider = 1 );
+
+	~PwmDoublePlayer();
+
+	/** Start playing from the current table position
+	 *
+	 *  @returns 0 on success, -1 if no PWM1 interrupt slot is free
+	 */
+	int start();
+
+	/** Stop playing; the outputs keep their last duty cycles */
+	void stop();
+
+	/** Set the number of PWM periods each table entry is held for */
+	void set_divider( uint32_t divider );
+
+protected:
+	static void irq( uintptr_t id );
+	void period();
+
+	PwmDoubleOut& _a;
+	PwmDoubleOut& _b;
+	PwmDoubleOut& _c;
+	const uint32_t* _table;
+	uint32_t _size;
+	volatile uint32_t _divider;
+	uint32_t _count;
+	uint32_t _index;
+	bool _running;
+};
+
+} // namespace mbed
+
+#endif
+
+#endif
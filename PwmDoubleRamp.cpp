@@ -0,0 +1,157 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "PwmDoubleRamp.h"
+#include "cmsis.h"
+
+namespace mbed {
+
+PwmDoubleRamp::PwmDoubleRamp( PwmDoubleOut& out, Target target ) :
+	_out( out ), _target( target ), _profile( LINEAR ), _from( 0 ), _to( 0 ),
+	_phase( 0 ), _increment( 0 ), _remaining( 0 ), _divider( 1 ), _count( 0 ),
+	_running( false ) {
+}
+
+PwmDoubleRamp::~PwmDoubleRamp() {
+	cancel();
+}
+
+int PwmDoubleRamp::start( uint32_t to, uint32_t steps, Profile profile, uint32_t divider ) {
+	if ( steps == 0 ) {
+		cancel();
+		_to = to;
+		apply( to );
+		return 0;
+	}
+	// keep the interrupt away while the ramp is rewritten, and only then
+	// look at _running: a last step could otherwise cancel in between
+	NVIC_DisableIRQ( PWM1_IRQn );
+	bool running = _running;
+	_from = current();
+	_to = to;
+	_profile = profile;
+	_phase = 0;
+	_increment = ( uint32_t )( ( 1ull << 32 ) / steps );
+	_remaining = steps;
+	_divider = divider ? divider : 1;
+	_count = 0;
+	if ( running ) {
+		NVIC_EnableIRQ( PWM1_IRQn );
+		return 0;
+	}
+	// set first: the first step may run before attach returns
+	_running = true;
+	if ( pwmdoubleout_irq_attach( &PwmDoubleRamp::irq, ( uintptr_t )this ) < 0 ) {
+		// all slots taken, so the interrupt was enabled
+		_running = false;
+		return -1;
+	}
+	return 0;
+}
+
+int PwmDoubleRamp::start_slew( uint32_t to, uint32_t rate, Profile profile, uint32_t divider ) {
+	uint32_t from = current();
+	uint32_t distance = ( to > from ) ? to - from : from - to;
+	uint32_t steps = 0;
+	if ( rate > 0 ) {
+		steps = distance / rate + ( distance % rate != 0 );
+	}
+	return start( to, steps, profile, divider );
+}
+
+void PwmDoubleRamp::cancel() {
+	if ( _running ) {
+		pwmdoubleout_irq_detach( &PwmDoubleRamp::irq, ( uintptr_t )this );
+		_running = false;
+	}
+}
+
+bool PwmDoubleRamp::running() const {
+	return _running;
+}
+
+uint32_t PwmDoubleRamp::target() const {
+	return _to;
+}
+
+uint32_t PwmDoubleRamp::current() {
+	switch ( _target ) {
+	case DUTY:
+		return _out.read_width();
+	case PHASE:
+		return _out.read_dephase();
+	default:
+		return pwmdoubleout_match[0];
+	}
+}
+
+void PwmDoubleRamp::apply( uint32_t value ) {
+	switch ( _target ) {
+	case DUTY:
+		_out.set_duty_cycle( value );
+		break;
+	case PHASE:
+		_out.set_dephase( value );
+		break;
+	default:
+		_out.retune( value );
+		break;
+	}
+}
+
+// As apply(), from the period interrupt: stored at once whatever groups
+// the interrupted code holds open, and outside the setter probes
+void PwmDoubleRamp::store( uint32_t value ) {
+	switch ( _target ) {
+	case DUTY:
+		_out.store_duty_cycle( value );
+		break;
+	case PHASE:
+		_out.store_dephase( value );
+		break;
+	default:
+		_out.store_retune( value );
+		break;
+	}
+}
+
+void PwmDoubleRamp::irq( uintptr_t id ) {
+	( ( PwmDoubleRamp* )id )->period();
+}
+
+void PwmDoubleRamp::period() {
+	if ( ++_count < _divider ) {
+		return;
+	}
+	_count = 0;
+
+	if ( --_remaining == 0 ) {
+		// land exactly on the target and free the interrupt slot
+		store( _to );
+		cancel();
+		return;
+	}
+	_phase += _increment;
+	// position along the ramp in Q16
+	uint32_t s = _phase >> 16;
+	if ( _profile == SCURVE ) {
+		uint32_t s2 = ( s * s ) >> 16;
+		s = ( uint32_t )( ( ( uint64_t )s2 * ( ( 3 << 16 ) - 2 * s ) ) >> 16 );
+	}
+	int64_t delta = ( int64_t )_to - ( int64_t )_from;
+	store( ( uint32_t )( _from + ( ( delta * s ) >> 16 ) ) );
+}
+
+} // namespace mbed
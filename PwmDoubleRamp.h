@@ -0,0 +1,130 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_PWMDOUBLERAMP_H
+#define MBED_PWMDOUBLERAMP_H
+
+#include "platform.h"
+
+#if DEVICE_PWMDOUBLEOUT
+#include "PwmDoubleOut.h"
+
+namespace mbed {
+
+/** Slews the duty cycle, dephase or period of a PwmDoubleOut to a target
+ *
+ * From the PWM1 period interrupt the ramp moves the parameter one step
+ * every 'divider' periods, from its value at start() to the target, along
+ * a linear or S-curve (3s^2 - 2s^3, zero slope at both ends) profile. Each
+ * step costs a few integer multiplies; the last step lands exactly on the
+ * target and the ramp then releases its interrupt slot.
+ *
+ * Calling start() while running retargets from the current value; cancel()
+ * freezes the parameter where it is. The steps are stored straight from the
+ * interrupt, so a PwmDoubleGroup held open by the main loop does not hold
+ * them back.
+ *
+ * Example
+ * @code
+ * PwmDoubleOut out( p25 );
+ * PwmDoubleRamp soft( out, PwmDoubleRamp::DUTY );
+ *
+ * out.set_freq( 192 );
+ * out.set_duty_cycle( 0 );
+ * soft.start( 96, 50000, PwmDoubleRamp::SCURVE ); // 0 -> 50% in 100 ms at 500 kHz
+ * @endcode
+ *
+ * @note
+ *  While a ramp runs, the ramped parameter must not be set directly. A
+ *  PERIOD ramp uses retune(), so every channel keeps its duty cycle and
+ *  dephase: each step scales the edges as they were last set, and rounds
+ *  once, so a ramp there and back returns them to the same ticks.
+ */
+class PwmDoubleRamp {
+
+public:
+
+	/** Parameter to ramp, in ticks */
+	enum Target {
+		DUTY,    /**< set_duty_cycle() */
+		PHASE,   /**< set_dephase() */
+		PERIOD   /**< retune() */
+	};
+
+	/** Shape of the ramp */
+	enum Profile {
+		LINEAR,  /**< constant slew */
+		SCURVE   /**< smooth start and stop, 1.5x the linear peak slew */
+	};
+
+	/** Create a ramp on one parameter of an output */
+	PwmDoubleRamp( PwmDoubleOut& out, Target target );
+
+	~PwmDoubleRamp();
+
+	/** Ramp to a value in a number of steps
+	 *
+	 *  @param to      Target value in ticks
+	 *  @param steps   Number of steps, 0 to jump to the target at once
+	 *  @param profile LINEAR or SCURVE
+	 *  @param divider PWM periods per step
+	 *  @returns 0 on success, -1 if no PWM1 interrupt slot is free
+	 */
+	int start( uint32_t to, uint32_t steps, Profile profile = LINEAR, uint32_t divider = 1 );
+
+	/** Ramp to a value at a given slew rate
+	 *
+	 *  @param to      Target value in ticks
+	 *  @param rate    Largest average change per step in ticks, 0 for no limit
+	 *  @param profile LINEAR or SCURVE
+	 *  @param divider PWM periods per step
+	 *  @returns 0 on success, -1 if no PWM1 interrupt slot is free
+	 */
+	int start_slew( uint32_t to, uint32_t rate, Profile profile = LINEAR, uint32_t divider = 1 );
+
+	/** Stop the ramp; the parameter keeps its current value */
+	void cancel();
+
+	/** Returns true while the ramp is moving */
+	bool running() const;
+
+	/** Returns the value the ramp is heading to */
+	uint32_t target() const;
+
+protected:
+	static void irq( uintptr_t id );
+	void period();
+	uint32_t current();
+	void apply( uint32_t value );
+	void store( uint32_t value );
+
+	PwmDoubleOut& _out;
+	Target _target;
+	Profile _profile;
+	uint32_t _from;
+	uint32_t _to;
+	uint32_t _phase;      // ramp position, 2^32 is the end
+	uint32_t _increment;  // _phase change per step
+	uint32_t _remaining;  // steps left
+	uint32_t _divider;
+	uint32_t _count;
+	volatile bool _running;
+};
+
+} // namespace mbed
+
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "PwmDoubleSequencer.h"
+#include "mbed_assert.h"
+
+namespace mbed {
+
+PwmDoubleSequencer::PwmDoubleSequencer( PwmDoubleStep* buffer, uint32_t size ) :
+	_buffer( buffer ), _mask( size - 1 ), _head( 0 ), _tail( 0 ),
+	_underruns( 0 ), _running( false ) {
+	MBED_ASSERT( size > 0 && ( size & ( size - 1 ) ) == 0 );
+}
+
+PwmDoubleSequencer::~PwmDoubleSequencer() {
+	stop();
+}
+
+int PwmDoubleSequencer::start() {
+	if ( _running ) {
+		return 0;
+	}
+	_underruns = 0;
+	if ( pwmdoubleout_irq_attach( &PwmDoubleSequencer::irq, ( uintptr_t )this ) < 0 ) {
+		return -1;
+	}
+	_running = true;
+	return 0;
+}
+
+void PwmDoubleSequencer::stop() {
+	if ( _running ) {
+		pwmdoubleout_irq_detach( &PwmDoubleSequencer::irq, ( uintptr_t )this );
+		_running = false;
+	}
+}
+
+bool PwmDoubleSequencer::push( const PwmDoubleStep& step ) {
+	uint32_t head = _head.load( std::memory_order_relaxed );
+	if ( head - _tail.load( std::memory_order_acquire ) > _mask ) {
+		return false;
+	}
+	_buffer[head & _mask] = step;
+	_head.store( head + 1, std::memory_order_release );
+	return true;
+}
+
+uint32_t PwmDoubleSequencer::push( const PwmDoubleStep* steps, uint32_t count ) {
+	uint32_t head = _head.load( std::memory_order_relaxed );
+	uint32_t free = _mask + 1 - ( head - _tail.load( std::memory_order_acquire ) );
+	if ( count > free ) {
+		count = free;
+	}
+	for ( uint32_t i = 0; i < count; i++ ) {
+		_buffer[( head + i ) & _mask] = steps[i];
+	}
+	_head.store( head + count, std::memory_order_release );
+	return count;
+}
+
+uint32_t PwmDoubleSequencer::pending() const {
+	return _head.load( std::memory_order_acquire ) - _tail.load( std::memory_order_acquire );
+}
+
+uint32_t PwmDoubleSequencer::space() const {
+	return _mask + 1 - pending();
+}
+
+uint32_t PwmDoubleSequencer::underruns() const {
+	return _underruns;
+}
+
+void PwmDoubleSequencer::irq( uintptr_t id ) {
+	( ( PwmDoubleSequencer* )id )->period();
+}
+
+void PwmDoubleSequencer::period() {
+	uint32_t tail = _tail.load( std::memory_order_relaxed );
+	if ( tail == _head.load( std::memory_order_acquire ) ) {
+		_underruns++;
+		return;
+	}
+	const PwmDoubleStep& step = _buffer[tail & _mask];
+	// latched for the next period start, even inside a PwmDoubleGroup
+	pwmdoubleout_store_match( step.match, step.mask );
+	_tail.store( tail + 1, std::memory_order_release );
+}
+
+} // namespace mbed
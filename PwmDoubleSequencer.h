@@ -0,0 +1,118 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_PWMDOUBLESEQUENCER_H
+#define MBED_PWMDOUBLESEQUENCER_H
+
+#include "platform.h"
+
+#if DEVICE_PWMDOUBLEOUT
+#include "pwmdoubleout_api.h"
+#include <atomic>
+
+namespace mbed {
+
+/** Match register values for one PWM period */
+struct PwmDoubleStep {
+	uint32_t match[7];  /**< MR0..MR6 */
+	uint32_t mask;      /**< Registers to load, bit n for MRn */
+};
+
+/** Replays a stream of per-period match tables on the PWM1 outputs
+ *
+ * Steps are queued in a caller-provided ring buffer. At every period start
+ * the PWM1 interrupt takes the next step, stores its match registers and
+ * latches them for the following period, so a step pushed now reaches the
+ * outputs one to two periods later. When the queue runs dry the outputs
+ * keep the last loaded configuration and underruns() is incremented.
+ * Steps bypass PwmDoubleGroup: a group held open by the code the interrupt
+ * preempted does not delay them.
+ *
+ * Example
+ * @code
+ * static PwmDoubleStep ring[64];
+ * PwmDoubleSequencer seq( ring, 64 );
+ *
+ * seq.start();
+ * while ( 1 ) {
+ *     PwmDoubleStep step = next_chirp_step();
+ *     while ( !seq.push( step ) );
+ * }
+ * @endcode
+ *
+ * @note
+ *  push() must only be called from one context at a time; the interrupt is
+ *  the only consumer.
+ */
+class PwmDoubleSequencer {
+
+public:
+
+	/** Create a sequencer on a preallocated ring
+	 *
+	 *  @param buffer Storage for queued steps
+	 *  @param size   Number of entries in buffer, a power of two
+	 */
+	PwmDoubleSequencer( PwmDoubleStep* buffer, uint32_t size );
+
+	~PwmDoubleSequencer();
+
+	/** Start replaying at the next period start
+	 *
+	 *  @returns 0 on success, -1 if no PWM1 interrupt slot is free
+	 */
+	int start();
+
+	/** Stop replaying; the outputs keep the last loaded step */
+	void stop();
+
+	/** Queue one step
+	 *
+	 *  @returns false if the ring is full
+	 */
+	bool push( const PwmDoubleStep& step );
+
+	/** Queue as many of count steps as fit
+	 *
+	 *  @returns The number of steps queued
+	 */
+	uint32_t push( const PwmDoubleStep* steps, uint32_t count );
+
+	/** Steps queued but not yet loaded */
+	uint32_t pending() const;
+
+	/** Free entries in the ring */
+	uint32_t space() const;
+
+	/** Periods that started with an empty queue since start() */
+	uint32_t underruns() const;
+
+protected:
+	static void irq( uintptr_t id );
+	void period();
+
+	PwmDoubleStep* _buffer;
+	uint32_t _mask;
+	std::atomic<uint32_t> _head;  // written by push()
+	std::atomic<uint32_t> _tail;  // written by the interrupt
+	volatile uint32_t _underruns;
+	bool _running;
+};
+
+} // namespace mbed
+
+#endif
+
+#endif
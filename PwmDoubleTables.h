@@ -0,0 +1,142 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_PWMDOUBLETABLES_H
+#define MBED_PWMDOUBLETABLES_H
+
+#include <stdint.h>
+
+namespace mbed {
+
+/** Compile-time duty tables for three-phase modulation
+ *
+ * SpwmTable and SvpwmTable hold one electrical cycle of phase A duty
+ * values, in ticks of a period of TICKS, sampled at N points. Phases B and
+ * C are the same table read N/3 and 2N/3 entries ahead, which
+ * PwmDoublePlayer does. MOD is the modulation index in per mille: 1000 is
+ * the largest undistorted amplitude (full swing for sinusoidal PWM, the
+ * 2/sqrt(3) extended range for space vector PWM).
+ *
+ * All trigonometry is evaluated by the compiler; the tables end up in flash.
+ *
+ * Example
+ * @code
+ * // 96 samples per cycle for MR0 = 192
+ * typedef SvpwmTable<96, 192> Table;
+ * PwmDoublePlayer player( u, v, w, Table::duty, Table::size );
+ * @endcode
+ */
+namespace pwmdouble_tables {
+
+template<unsigned... I> struct index_list {};
+template<unsigned N, unsigned... I>
+struct make_index_list : make_index_list < N - 1, N - 1, I... > {};
+template<unsigned... I>
+struct make_index_list<0, I...> {
+	typedef index_list<I...> type;
+};
+
+constexpr double PI = 3.14159265358979323846;
+constexpr double SQRT3 = 1.73205080756887729353;
+
+// Taylor series of sin(x), accurate to double precision for |x| <= pi
+constexpr double sin_series( double x2, double term, int n ) {
+	return ( n > 25 ) ? term :
+	       term + sin_series( x2, -term * x2 / ( ( n + 1 ) * ( n + 2 ) ), n + 2 );
+}
+
+constexpr double sin_radians( double x ) {
+	return sin_series( x * x, x, 1 );
+}
+
+// Fractional part of turns mapped to [-0.5, 0.5)
+constexpr double wrap_turns( double frac ) {
+	return ( frac >= 0.5 ) ? frac - 1 : frac;
+}
+
+// sin(2 pi turns) for any turns >= 0
+constexpr double sin_turns( double turns ) {
+	return sin_radians( 2 * PI * wrap_turns( turns - ( long )turns ) );
+}
+
+constexpr double max3( double a, double b, double c ) {
+	return ( a > b ) ? ( ( a > c ) ? a : c ) : ( ( b > c ) ? b : c );
+}
+
+constexpr double min3( double a, double b, double c ) {
+	return ( a < b ) ? ( ( a < c ) ? a : c ) : ( ( b < c ) ? b : c );
+}
+
+constexpr uint32_t to_ticks( double duty, uint32_t ticks ) {
+	return ( uint32_t )( duty * ticks + 0.5 );
+}
+
+// Sinusoidal PWM: 0.5 + m/2 sin(theta)
+constexpr uint32_t spwm_duty( unsigned i, unsigned n, uint32_t ticks, unsigned mod ) {
+	return to_ticks( 0.5 + 0.5 * ( mod / 1000.0 ) * sin_turns( ( double )i / n ), ticks );
+}
+
+// Space vector PWM as min-max zero sequence injection on the three sines
+constexpr double svpwm_offset( double a, double b, double c ) {
+	return -( max3( a, b, c ) + min3( a, b, c ) ) / 2;
+}
+
+constexpr uint32_t svpwm_duty( unsigned i, unsigned n, uint32_t ticks, unsigned mod ) {
+	return to_ticks( 0.5 + ( mod / 1000.0 ) / SQRT3 *
+	                 ( sin_turns( ( double )i / n ) +
+	                   svpwm_offset( sin_turns( ( double )i / n ),
+	                                 sin_turns( ( double )i / n + 2.0 / 3 ),
+	                                 sin_turns( ( double )i / n + 1.0 / 3 ) ) ), ticks );
+}
+
+template < unsigned N, uint32_t TICKS, unsigned MOD,
+           class L = typename make_index_list<N>::type > struct spwm;
+template<unsigned N, uint32_t TICKS, unsigned MOD, unsigned... I>
+struct spwm<N, TICKS, MOD, index_list<I...> > {
+	static constexpr uint32_t duty[N] = { spwm_duty( I, N, TICKS, MOD )... };
+};
+template<unsigned N, uint32_t TICKS, unsigned MOD, unsigned... I>
+constexpr uint32_t spwm<N, TICKS, MOD, index_list<I...> >::duty[N];
+
+template < unsigned N, uint32_t TICKS, unsigned MOD,
+           class L = typename make_index_list<N>::type > struct svpwm;
+template<unsigned N, uint32_t TICKS, unsigned MOD, unsigned... I>
+struct svpwm<N, TICKS, MOD, index_list<I...> > {
+	static constexpr uint32_t duty[N] = { svpwm_duty( I, N, TICKS, MOD )... };
+};
+template<unsigned N, uint32_t TICKS, unsigned MOD, unsigned... I>
+constexpr uint32_t svpwm<N, TICKS, MOD, index_list<I...> >::duty[N];
+
+} // namespace pwmdouble_tables
+
+/** Sinusoidal PWM duty table, N samples per cycle for a period of TICKS */
+template<unsigned N, uint32_t TICKS, unsigned MOD = 1000>
+struct SpwmTable : pwmdouble_tables::spwm<N, TICKS, MOD> {
+	static_assert( N % 3 == 0, "phases are N/3 entries apart" );
+	static_assert( MOD <= 1000, "modulation index above 1000 per mille" );
+	static const uint32_t size = N;
+};
+
+/** Space vector PWM duty table, N samples per cycle for a period of TICKS */
+template<unsigned N, uint32_t TICKS, unsigned MOD = 1000>
+struct SvpwmTable : pwmdouble_tables::svpwm<N, TICKS, MOD> {
+	static_assert( N % 3 == 0, "phases are N/3 entries apart" );
+	static_assert( MOD <= 1000, "modulation index above 1000 per mille" );
+	static const uint32_t size = N;
+};
+
+} // namespace mbed
+
+#endif
@@ -0,0 +1,107 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "PwmInterleaved.h"
+#include "PwmDoubleGroup.h"
+#include "mbed_assert.h"
+
+namespace mbed {
+
+PwmInterleaved::PwmInterleaved( PwmDoubleOut& a, PwmDoubleOut& b, int phases ) :
+	_count( 2 ), _phases( phases ), _fraction( 0 ) {
+	MBED_ASSERT( phases >= _count );
+	_out[0] = &a;
+	_out[1] = &b;
+	_out[2] = 0;
+	check_channels();
+	update();
+}
+
+PwmInterleaved::PwmInterleaved( PwmDoubleOut& a, PwmDoubleOut& b, PwmDoubleOut& c,
+                                int phases ) :
+	_count( 3 ), _phases( phases ), _fraction( 0 ) {
+	MBED_ASSERT( phases >= _count );
+	_out[0] = &a;
+	_out[1] = &b;
+	_out[2] = &c;
+	check_channels();
+	update();
+}
+
+// Adjacent channels share a match register: the fall edge of one is the
+// rise edge of the next
+void PwmInterleaved::check_channels() {
+	for ( int j = 1; j < _count; j++ ) {
+		for ( int k = 0; k < j; k++ ) {
+			int apart = _out[j]->channel() - _out[k]->channel();
+			MBED_ASSERT( apart >= 2 || apart <= -2 );
+			( void )apart;
+		}
+	}
+}
+
+void PwmInterleaved::set_duty_cycle( int value ) {
+	uint32_t period = pwmdoubleout_match[0];
+	uint32_t width = ( value < 0 ) ? 0 : ( uint32_t )value;
+	if ( period == 0 || width >= period ) {
+		_fraction = PWMDOUBLEOUT_Q16_ONE;
+	} else {
+		// rounded up, so that update() gets back the width set, not one
+		// tick less, for any period up to 65536 ticks
+		_fraction = ( uint32_t )( ( ( ( uint64_t )width << 16 ) + period - 1 ) / period );
+	}
+	update();
+}
+
+void PwmInterleaved::write_q16( uint32_t fraction ) {
+	_fraction = ( fraction > PWMDOUBLEOUT_Q16_ONE ) ? PWMDOUBLEOUT_Q16_ONE : fraction;
+	update();
+}
+
+void PwmInterleaved::set_freq( int value ) {
+	PwmDoubleGroup group;
+	_out[0]->set_freq( value );
+	update();
+}
+
+void PwmInterleaved::set_phases( int phases ) {
+	MBED_ASSERT( phases >= _count );
+	_phases = phases;
+	update();
+}
+
+void PwmInterleaved::update() {
+	uint32_t period = pwmdoubleout_match[0];
+	int width = ( int )( ( ( uint64_t )period * _fraction ) >> 16 );
+
+	// every edge latches on the same period start
+	PwmDoubleGroup group;
+	uint32_t rise = 0;
+	uint32_t step = period / _phases;
+	uint32_t rem = period % _phases;
+	uint32_t acc = 0;
+	for ( int k = 0; k < _count; k++ ) {
+		_out[k]->set_edges( rise, width );
+		// k * period / phases without a divide per channel
+		rise += step;
+		acc += rem;
+		if ( acc >= ( uint32_t )_phases ) {
+			acc -= _phases;
+			rise++;
+		}
+	}
+}
+
+} // namespace mbed
@@ -0,0 +1,94 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_PWMINTERLEAVED_H
+#define MBED_PWMINTERLEAVED_H
+
+#include "platform.h"
+
+#if DEVICE_PWMDOUBLEOUT
+#include "PwmDoubleOut.h"
+
+namespace mbed {
+
+/** Evenly interleaved double edge outputs for multi-phase converters
+ *
+ * Channel k rises at k * period / phases and all channels share one duty
+ * cycle. Every change recomputes the rise and fall edges of all channels
+ * in one pass and latches them in a single PwmDoubleGroup transaction, so
+ * the phase spacing survives duty cycle and frequency changes.
+ *
+ * Example
+ * @code
+ * PwmDoubleOut a( p25 ), b( p23 ), c( p21 );
+ * PwmInterleaved buck( a, b, c );  // three phases, 120 degrees apart
+ *
+ * buck.set_freq( 192 );
+ * buck.set_duty_cycle( 48 );
+ * @endcode
+ *
+ * @note
+ *  The channels must not be adjacent: PWM1.n rises on MR(n-1) and falls on
+ *  MRn, so e.g. PWM1.2 and PWM1.3 share MR2 and cannot take independent
+ *  edges. Use every other channel, such as PWM1.2, PWM1.4 and PWM1.6.
+ *
+ * @note
+ *  phases may exceed the number of channels, e.g. two channels with
+ *  phases = 4 sit 90 degrees apart.
+ */
+class PwmInterleaved {
+
+public:
+
+	/** Interleave two channels
+	 *
+	 *  @param phases Number of phase slots in a period, at least 2
+	 */
+	PwmInterleaved( PwmDoubleOut& a, PwmDoubleOut& b, int phases = 2 );
+
+	/** Interleave three channels
+	 *
+	 *  @param phases Number of phase slots in a period, at least 3
+	 */
+	PwmInterleaved( PwmDoubleOut& a, PwmDoubleOut& b, PwmDoubleOut& c, int phases = 3 );
+
+	/** Set the common duty-cycle, specified as the register value (int) */
+	void set_duty_cycle( int value );
+
+	/** Set the common duty-cycle, specified as a Q16 fraction of the period */
+	void write_q16( uint32_t fraction );
+
+	/** Set the PWM period, specified as the MR0 register value (int),
+	 *  keeping the duty ratio and the phase spacing */
+	void set_freq( int value );
+
+	/** Change the number of phase slots */
+	void set_phases( int phases );
+
+protected:
+	void check_channels();
+	void update();
+
+	PwmDoubleOut* _out[3];
+	int _count;
+	int _phases;
+	uint32_t _fraction;  // duty cycle, Q16 of the period
+};
+
+} // namespace mbed
+
+#endif
+
+#endif
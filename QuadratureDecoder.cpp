@@ -0,0 +1,96 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "QuadratureDecoder.h"
+
+/* Quarter step for each ( previous state << 2 | state ), state = A << 1 | B.
+ * Forward is 00 -> 01 -> 11 -> 10; 2 marks a skipped state. */
+static const int8_t QUADRATURE_TABLE[16] = {
+	0, 1, -1, 2,
+	-1, 0, 2, 1,
+	1, 2, 0, -1,
+	2, -1, 1, 0
+};
+
+QuadratureDecoder::QuadratureDecoder( uint32_t counts_per_detent,
+                                      uint32_t accel_ref_us, uint32_t accel_max ) :
+	_state( 0 ), _dir( 0 ), _timed( false ), _partial( 0 ), _position( 0 ),
+	_counts( counts_per_detent ? counts_per_detent : 1 ),
+	_accel_ref( accel_ref_us ), _accel_max( accel_max ? accel_max : 1 ),
+	_last_us( 0 ), _errors( 0 ) {
+}
+
+void QuadratureDecoder::reset( int a, int b ) {
+	_state = ( ( a != 0 ) << 1 ) | ( b != 0 );
+	_dir = 0;
+	_timed = false;
+	_partial = 0;
+	_position = 0;
+	_errors = 0;
+}
+
+int32_t QuadratureDecoder::edge( int a, int b, uint32_t now_us ) {
+	uint8_t state = ( ( a != 0 ) << 1 ) | ( b != 0 );
+	int8_t step = QUADRATURE_TABLE[( _state << 2 ) | state];
+	_state = state;
+	if ( step == 2 ) {
+		_errors++;
+		return 0;
+	}
+	_position += step;
+	_partial += step;
+	if ( _partial < ( int32_t )_counts && _partial > -( int32_t )_counts ) {
+		return 0;
+	}
+	int8_t dir = _partial > 0 ? 1 : -1;
+	_partial = 0;
+
+	uint32_t steps = 1;
+	if ( dir == _dir && _timed ) {
+		steps = gain( now_us - _last_us );
+	}
+	_dir = dir;
+	_last_us = now_us;
+	_timed = true;
+	return dir * ( int32_t )steps;
+}
+
+void QuadratureDecoder::set_acceleration( uint32_t accel_ref_us, uint32_t accel_max ) {
+	_accel_ref = accel_ref_us;
+	_accel_max = accel_max ? accel_max : 1;
+}
+
+int32_t QuadratureDecoder::position() const {
+	return _position;
+}
+
+uint32_t QuadratureDecoder::errors() const {
+	return _errors;
+}
+
+uint32_t QuadratureDecoder::gain( uint32_t dt_us ) const {
+	if ( dt_us >= _accel_ref ) {
+		return 1;
+	}
+	if ( dt_us == 0 ) {
+		return _accel_max;
+	}
+	// ( ref / dt )^2 without overflow: ref / dt < 2^16 keeps the square in range
+	uint32_t ratio = _accel_ref / dt_us;
+	if ( ratio >= 0x10000 || ratio * ratio >= _accel_max ) {
+		return _accel_max;
+	}
+	return ratio * ratio;
+}
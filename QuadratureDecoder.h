@@ -0,0 +1,96 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef QUADRATUREDECODER_H
+#define QUADRATUREDECODER_H
+
+#include <stdint.h>
+
+/** Full-resolution (4x) quadrature decoder with detent acceleration
+ *
+ * Feed it the level of both encoder lines on every edge of either line.
+ * Each valid Gray-code transition counts one quarter step; transitions
+ * that skip a state (both lines changed, i.e. an edge was missed) are
+ * counted in errors() and ignored. Contact bounce only moves the count
+ * back and forth across one transition, so no debounce delay is needed.
+ *
+ * Once a full detent is accumulated, edge() returns the signed number of
+ * steps for it. Detents closer than the acceleration reference time are
+ * multiplied by ( ref / dt )^2, capped at the maximum gain, so a slow turn
+ * still moves one step per detent while a quick spin covers the range. A
+ * change of direction always restarts at gain 1.
+ *
+ * Example
+ * @code
+ * QuadratureDecoder decoder;
+ *
+ * void onEdge() {
+ *     int32_t steps = decoder.edge( a.read(), b.read(), us_ticker_read() );
+ *     if ( steps != 0 ) {
+ *         value += steps;
+ *     }
+ * }
+ * @endcode
+ */
+class QuadratureDecoder {
+
+public:
+
+	/** Create a decoder
+	 *
+	 *  @param counts_per_detent Quarter steps in one mechanical detent
+	 *  @param accel_ref_us      Detent interval below which acceleration starts
+	 *  @param accel_max         Largest steps per detent, 1 disables acceleration
+	 */
+	QuadratureDecoder( uint32_t counts_per_detent = 4,
+	                   uint32_t accel_ref_us = 60000, uint32_t accel_max = 1000 );
+
+	/** Set the line levels at start-up, before the first edge */
+	void reset( int a, int b );
+
+	/** Process an edge on either line
+	 *
+	 *  @param a       Current level of line A
+	 *  @param b       Current level of line B
+	 *  @param now_us  Timestamp of the edge in us, free running
+	 *  @returns Signed steps to apply, 0 if no detent completed
+	 */
+	int32_t edge( int a, int b, uint32_t now_us );
+
+	/** Change the acceleration curve */
+	void set_acceleration( uint32_t accel_ref_us, uint32_t accel_max );
+
+	/** Signed quarter steps since reset */
+	int32_t position() const;
+
+	/** Transitions rejected because a state was skipped */
+	uint32_t errors() const;
+
+protected:
+	uint32_t gain( uint32_t dt_us ) const;
+
+	uint8_t _state;
+	int8_t _dir;
+	bool _timed;
+	int32_t _partial;
+	int32_t _position;
+	uint32_t _counts;
+	uint32_t _accel_ref;
+	uint32_t _accel_max;
+	uint32_t _last_us;
+	uint32_t _errors;
+};
+
+#endif
@@ -0,0 +1,87 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <stdint.h>
+
+/** A lock-free single-producer/single-consumer ring of N - 1 elements
+ *
+ * One context (typically an interrupt) calls push(), one other context
+ * calls pop(). Neither blocks and no interrupt masking is needed: each
+ * index is written by only one side and published with release ordering.
+ *
+ * @code
+ * SpscQueue<Command, 16> queue;
+ *
+ * void isr() {
+ *     queue.push( cmd );   // false if full
+ * }
+ *
+ * while ( queue.pop( cmd ) ) {
+ *     handle( cmd );
+ * }
+ * @endcode
+ */
+template<typename T, uint32_t N>
+class SpscQueue {
+	static_assert( N >= 2 && ( N & ( N - 1 ) ) == 0, "N must be a power of two" );
+
+public:
+	SpscQueue() : _head( 0 ), _tail( 0 ) {
+	}
+
+	/** Append an element; producer side only
+	 *
+	 *  @returns false if the queue is full
+	 */
+	bool push( const T& value ) {
+		uint32_t head = _head.load( std::memory_order_relaxed );
+		uint32_t next = ( head + 1 ) & ( N - 1 );
+		if ( next == _tail.load( std::memory_order_acquire ) ) {
+			return false;
+		}
+		_buffer[head] = value;
+		_head.store( next, std::memory_order_release );
+		return true;
+	}
+
+	/** Remove the oldest element; consumer side only
+	 *
+	 *  @returns false if the queue is empty
+	 */
+	bool pop( T& value ) {
+		uint32_t tail = _tail.load( std::memory_order_relaxed );
+		if ( tail == _head.load( std::memory_order_acquire ) ) {
+			return false;
+		}
+		value = _buffer[tail];
+		_tail.store( ( tail + 1 ) & ( N - 1 ), std::memory_order_release );
+		return true;
+	}
+
+	bool empty() const {
+		return _tail.load( std::memory_order_acquire ) == _head.load( std::memory_order_acquire );
+	}
+
+private:
+	T _buffer[N];
+	std::atomic<uint32_t> _head;
+	std::atomic<uint32_t> _tail;
+};
+
+#endif
@@ -0,0 +1,159 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_STATICPWMDOUBLEOUT_H
+#define MBED_STATICPWMDOUBLEOUT_H
+
+#include "platform.h"
+
+#if DEVICE_PWMDOUBLEOUT
+#include "pwmdoubleout_api.h"
+#include "cmsis.h"
+
+namespace mbed {
+
+/** A double edge PWM output whose channel is fixed at compile time
+ *
+ * The PWM channel, its match registers and LER bits are derived from the
+ * pin at compile time, so the setters inline to the cache update and direct
+ * register stores with no object state or pointer indirection. Pins on
+ * channel 1 are rejected: its rise edge would be MR0, the period register.
+ *
+ * Example
+ * @code
+ * StaticPwmDoubleOut<p23> waveB;
+ *
+ * void isr() {
+ *     waveB.set_duty_cycle( 96 );
+ * }
+ * @endcode
+ *
+ * @note
+ *  The channel shares the driver cache with PwmDoubleOut and honours
+ *  PwmDoubleGroup transactions, so both kinds can be mixed freely.
+ */
+template<PinName PIN>
+class StaticPwmDoubleOut {
+
+public:
+
+	/** PWM1 channel driven by PIN, 0 if the pin has no PWM function */
+	static constexpr int channel() {
+		return ( PIN == P1_18 || PIN == P2_0 ) ? 1 :
+		       ( PIN == P1_20 || PIN == P2_1 || PIN == P3_25 ) ? 2 :
+		       ( PIN == P1_21 || PIN == P2_2 || PIN == P3_26 ) ? 3 :
+		       ( PIN == P1_23 || PIN == P2_3 ) ? 4 :
+		       ( PIN == P1_24 || PIN == P2_4 ) ? 5 :
+		       ( PIN == P1_26 || PIN == P2_5 ) ? 6 : 0;
+	}
+
+	static_assert( channel() != 0, "pin has no PWM1 function" );
+	static_assert( channel() != 1,
+	               "PWM1.1 cannot run double edge: its rise edge would be MR0" );
+
+	/** Initialise the channel in double edge mode
+	 */
+	StaticPwmDoubleOut() {
+		pwmdoubleout_t obj;
+		pwmdoubleout_init( &obj, PIN );
+	}
+
+	/** Set the ouput duty-cycle, specified as the register value (int)
+	 */
+	void set_duty_cycle( int value ) {
+		store( pwmdoubleout_cache_duty( channel(), value ) );
+	}
+
+	/** Set the ouput dephase, specified as the register value (int)
+	 */
+	void set_dephase( int value ) {
+		// keep the pulse width
+		set_edges( value, pwmdoubleout_width[channel()] );
+	}
+
+	/** Set the dephase and the duty-cycle together, both specified as register values (int)
+	 */
+	void set_edges( int rise, int width ) {
+		store( pwmdoubleout_cache_edges( channel(), rise, width ) );
+	}
+
+	/** Set the ouput duty-cycle, specified as a Q16 fraction of the period
+	 */
+	void write_q16( uint32_t fraction ) {
+		set_duty_cycle( pwmdoubleout_q16_ticks( fraction ) );
+	}
+
+	/** Set the ouput dephase, specified as a Q16 fraction of the period
+	 */
+	void dephase_q16( uint32_t fraction ) {
+		set_dephase( pwmdoubleout_q16_ticks( fraction ) );
+	}
+
+	/** Return the current output duty-cycle setting as a Q16 fraction of the period
+	 */
+	uint32_t read_q16() const {
+		return pwmdoubleout_width_q16( channel() );
+	}
+
+	/** Set the PWM period, specified as the MR0 register value (int).
+	 *  The channels keep their rise edge and pulse width in ticks, wrapped
+	 *  into the new period.
+	 */
+	void set_freq( int value ) {
+		// the period is shared by all channels, no channel state is needed
+		pwmdoubleout_set_freq( 0, value );
+	}
+
+	/** Set the PWM period in ticks, keeping every channel's duty cycle and dephase
+	 */
+	void retune( int value ) {
+		pwmdoubleout_retune( 0, value );
+	}
+
+private:
+	static const uint32_t MASK_A = 1 << ( channel() - 1 );
+	static const uint32_t MASK_B = 1 << channel();
+
+	static constexpr __IO uint32_t LPC_PWM_TypeDef::* match_register( int n ) {
+		return ( n == 0 ) ? &LPC_PWM_TypeDef::MR0 :
+		       ( n == 1 ) ? &LPC_PWM_TypeDef::MR1 :
+		       ( n == 2 ) ? &LPC_PWM_TypeDef::MR2 :
+		       ( n == 3 ) ? &LPC_PWM_TypeDef::MR3 :
+		       ( n == 4 ) ? &LPC_PWM_TypeDef::MR4 :
+		       ( n == 5 ) ? &LPC_PWM_TypeDef::MR5 : &LPC_PWM_TypeDef::MR6;
+	}
+
+	// Store the cached match registers in mask with the channel's own
+	// registers, or stage them in the open group
+	static void store( uint32_t mask ) {
+		if ( pwmdoubleout_group_depth > 0 ) {
+			pwmdoubleout_group_mask |= mask;
+		} else {
+			if ( mask & MASK_A ) {
+				LPC_PWM1->*match_register( channel() - 1 ) = pwmdoubleout_match[channel() - 1];
+			}
+			LPC_PWM1->*match_register( channel() ) = pwmdoubleout_match[channel()];
+			// accept on next period start
+			pwmdoubleout_ler_set( mask );
+		}
+		pwmdoubleout_check( channel() );
+	}
+};
+
+} // namespace mbed
+
+#endif
+
+#endif
@@ -22,11 +22,16 @@
 
 #include "TextLCD.h"
 #include "mbed.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
 
 TextLCD::TextLCD( PinName rs, PinName e, PinName d0, PinName d1,
                   PinName d2, PinName d3, LCDType type ) : _rs( rs ),
 	_e( e ), _d( d0, d1, d2, d3 ),
-	_type( type ) {
+	_type( type ), _commands( 0 ), _data( 0 ),
+	_cursorColumn( 0 ), _cursorRow( 0 ), _async( 0 ),
+	_running( false ), _phase( 0 ), _entry( 0 ), _idle( NULL ) {
 
 	_e  = 1;
 	_rs = 0;            // command mode
@@ -49,17 +54,68 @@ TextLCD::TextLCD( PinName rs, PinName e, PinName d0, PinName d1,
 }
 
 void TextLCD::character( int column, int row, int c ) {
-	int a = address( column, row );
-	writeCommand( a );
-	writeData( c );
+	if ( column < 0 || column >= columns() || row < 0 || row >= rows() ) {
+		return;
+	}
+	if ( ( unsigned char )_frame[row][column] != ( unsigned char )c ) {
+		_frame[row][column] = c;
+		_dirty[row] |= 1UL << column;
+	}
 }
 
 void TextLCD::cls() {
-	writeCommand( 0x01 ); // cls, and set cursor to 0
-	wait( 0.00164f );   // This command takes 1.64 ms
+	if ( _async ) {
+		_commands++;
+		queueByte( 0x01 | TX_SLOW ); // cls, and set cursor to 0
+	} else {
+		writeCommand( 0x01 ); // cls, and set cursor to 0
+		wait( 0.00164f );   // This command takes 1.64 ms
+	}
+	memset( _frame, ' ', sizeof( _frame ) );
+	memset( _dirty, 0, sizeof( _dirty ) );
+	_cursorColumn = 0;
+	_cursorRow = 0;
 	locate( 0, 0 );
 }
 
+void TextLCD::flush() {
+	if ( writeDirty() ) {
+		// the address counter moved with the data, put the cursor back
+		writeCommand( address( _cursorColumn, _cursorRow ) );
+	}
+}
+
+bool TextLCD::writeDirty() {
+	bool sent = false;
+	for ( int row = 0; row < rows(); row++ ) {
+		uint32_t dirty = _dirty[row];
+		int column = 0;
+		while ( dirty >> column ) {
+			// skip to the next run of changed cells and find its end
+			while ( !( ( dirty >> column ) & 1 ) ) {
+				column++;
+			}
+			int end = column;
+			while ( end < columns() && ( ( dirty >> end ) & 1 ) ) {
+				end++;
+			}
+			writeRun( column, row, end );
+			column = end;
+			sent = true;
+		}
+		_dirty[row] = 0;
+	}
+	return sent;
+}
+
+void TextLCD::writeRun( int column, int row, int end ) {
+	writeCommand( address( column, row ) );
+	// the address counter auto-increments after each data write
+	for ( ; column < end; column++ ) {
+		writeData( _frame[row][column] );
+	}
+}
+
 void TextLCD::locate( int column, int row ) {
 	_column = column;
 	_row = row;
@@ -86,11 +142,82 @@ int TextLCD::_putc( int value ) {
 	return value;
 }
 
+int TextLCD::putc( int c ) {
+	_putc( c );
+	flush();
+	return c;
+}
+
+int TextLCD::printf( const char* format, ... ) {
+	// one 20x4 screen and a newline per row
+	char buffer[4 * 21 + 1];
+	va_list args;
+	va_start( args, format );
+	int n = vsnprintf( buffer, sizeof( buffer ), format, args );
+	va_end( args );
+	printString( buffer );
+	flush();
+	return n;
+}
+
+void TextLCD::printString( const char* s ) {
+	while ( *s ) {
+		_putc( *s++ );
+	}
+}
+
+void TextLCD::printInt( uint32_t value, int width ) {
+	char digits[10];
+	int n = 0;
+	do {
+		digits[n++] = '0' + value % 10;
+		value /= 10;
+	} while ( value );
+	for ( ; width > n; width-- ) {
+		_putc( '0' );
+	}
+	while ( n ) {
+		_putc( digits[--n] );
+	}
+}
+
+void TextLCD::printTenths( uint32_t num, uint32_t den, int width ) {
+	if ( den == 0 ) {
+		printDashes( width );
+		return;
+	}
+	// tenths of a percent; 64 bit so any num < 2^32 fits
+	uint64_t scaled = ( uint64_t )num * 1000;
+	uint32_t tenths = ( uint32_t )( scaled / den );
+	uint64_t twice = ( scaled % den ) * 2;
+	// round to nearest, ties to even like printf
+	if ( twice > den || ( twice == den && ( tenths & 1 ) ) ) {
+		tenths++;
+	}
+	printInt( tenths / 10, width > 3 ? width - 2 : 1 );
+	_putc( '.' );
+	_putc( '0' + tenths % 10 );
+}
+
+void TextLCD::printKhz( uint32_t ticks, uint32_t clock_khz, int width ) {
+	if ( ticks == 0 ) {
+		printDashes( width );
+		return;
+	}
+	printInt( clock_khz / ticks, width );
+}
+
+void TextLCD::printDashes( int width ) {
+	for ( int i = 0; i < width; i++ ) {
+		_putc( '-' );
+	}
+}
+
 void TextLCD::insert( int c ) {
 	int row = _row;
 	int column = _column;
 	_putc( c );
-	moveCursor( column, row ); //move cursor back to original position
+	moveCursor( column, row ); //flush and move cursor back to original position
 }
 
 int TextLCD::_getc() {
@@ -99,11 +226,16 @@ int TextLCD::_getc() {
 
 void TextLCD::setCursor( int value ) {
 	writeCommand( 0xC | ( 0x3 * value ) );
-	wait( 0.000040f ); // most instructions take 40us
+	if ( !_async ) {
+		wait( 0.000040f ); // most instructions take 40us
+	}
 }
 
 void TextLCD::moveCursor( int column, int row ) {
 	locate( column, row );
+	_cursorColumn = column;
+	_cursorRow = row;
+	writeDirty();
 	int a = address( column, row );
 	writeCommand( a );
 }
@@ -122,15 +254,96 @@ void TextLCD::writeByte( int value ) {
 }
 
 void TextLCD::writeCommand( int command ) {
+	_commands++;
+	if ( _async ) {
+		queueByte( command & 0xFF );
+		return;
+	}
 	_rs = 0;
 	writeByte( command );
 }
 
 void TextLCD::writeData( int data ) {
+	_data++;
+	if ( _async ) {
+		queueByte( ( data & 0xFF ) | TX_RS );
+		return;
+	}
 	_rs = 1;
 	writeByte( data );
 }
 
+void TextLCD::setAsync( int value ) {
+	if ( !value ) {
+		waitIdle();
+	}
+	_async = value;
+}
+
+unsigned int TextLCD::commandCount() {
+	return _commands;
+}
+
+unsigned int TextLCD::dataCount() {
+	return _data;
+}
+
+int TextLCD::busy() {
+	return _running;
+}
+
+void TextLCD::waitIdle() {
+	while ( _running );
+}
+
+void TextLCD::attach( void ( *fptr )( void ) ) {
+	_idle = fptr;
+}
+
+void TextLCD::queueByte( uint16_t entry ) {
+	while ( !_tx.push( entry ) ); // full: the interrupt is draining it
+	__disable_irq();
+	if ( !_running ) {
+		_running = true;
+		_tick.attach_us( this, &TextLCD::clock, 1 );
+	}
+	__enable_irq();
+}
+
+/* Same sequence as writeByte(), one step per interrupt */
+void TextLCD::clock() {
+	int delay = 40; // most instructions take 40us
+	switch ( _phase ) {
+	case 0:
+		_e = 1;
+		if ( !_tx.pop( _entry ) ) {
+			_running = false;
+			if ( _idle ) {
+				_idle();
+			}
+			return;
+		}
+		_rs = ( _entry & TX_RS ) ? 1 : 0;
+		_d = _entry >> 4;
+		break;
+	case 1:
+		_e = 0;
+		break;
+	case 2:
+		_e = 1;
+		_d = _entry >> 0;
+		break;
+	case 3:
+		_e = 0;
+		if ( _entry & TX_SLOW ) {
+			delay = 1640; // This command takes 1.64 ms
+		}
+		break;
+	}
+	_phase = ( _phase + 1 ) & 3;
+	_tick.attach_us( this, &TextLCD::clock, delay );
+}
+
 int TextLCD::address( int column, int row ) {
 	switch ( _type ) {
 	case LCD20x4:
@@ -24,11 +24,23 @@
 #define MBED_TEXTLCD_H
 
 #include "mbed.h"
+#include "SpscQueue.h"
 
 /** A TextLCD interface for driving 4-bit HD44780-based LCDs
  *
  * Currently supports 16x2, 20x2 and 20x4 panels
  *
+ * Characters are written to a shadow framebuffer; only cells whose
+ * content changed are sent to the panel on flush(), one address command
+ * per run of consecutive changed cells. putc(), printf(), moveCursor(),
+ * insert() and cls() flush before they return. printString(), printInt(),
+ * printTenths() and printKhz() only fill the framebuffer, so that a whole
+ * screen can be composed and sent with one flush() or moveCursor().
+ *
+ * In async mode (setAsync) bus writes are queued and clocked out from a
+ * Timeout interrupt with the HD44780 timing, so printing never blocks
+ * unless the queue is full.
+ *
  * @code
  * #include "mbed.h"
  * #include "TextLCD.h"
@@ -61,20 +73,53 @@ public:
 	TextLCD( PinName rs, PinName e, PinName d0, PinName d1, PinName d2, PinName d3,
 	         LCDType type = LCD16x2 );
 
-#if DOXYGEN_ONLY
-	/** Write a character to the LCD
+	/** Write a character to the LCD and flush
 	 *
 	 * @param c The character to write to the display
 	 */
 	int putc( int c );
 
-	/** Write a formated string to the LCD
+	/** Write a formated string to the LCD and flush
 	 *
 	 * @param format A printf-style format string, followed by the
-	 *               variables to use in formating the string.
+	 *               variables to use in formating the string. Up to
+	 *               84 characters are written, a 20x4 screen with
+	 *               a newline per row.
 	 */
 	int printf( const char* format, ... );
-#endif
+
+	/** Write a string at the current position, without going through stdio
+	 *
+	 * @param s Zero terminated string
+	 */
+	void printString( const char* s );
+
+	/** Write an unsigned integer, zero padded like "%0*u"
+	 *
+	 * @param value The value to write
+	 * @param width Minimum number of digits
+	 */
+	void printInt( uint32_t value, int width );
+
+	/** Write 100 * num / den with one decimal, like "%0*.1f" of a percentage
+	 *
+	 * Rounded to the nearest tenth; writes dashes if den is 0.
+	 *
+	 * @param num   Numerator, num <= den
+	 * @param den   Denominator
+	 * @param width Minimum field width, including the decimal point
+	 */
+	void printTenths( uint32_t num, uint32_t den, int width );
+
+	/** Write the frequency of a period given in timer ticks, in kHz
+	 *
+	 * Truncated like an integer division; writes dashes if ticks is 0.
+	 *
+	 * @param ticks     Period in ticks
+	 * @param clock_khz Timer clock in kHz
+	 * @param width     Minimum number of digits
+	 */
+	void printKhz( uint32_t ticks, uint32_t clock_khz, int width );
 
 	/** Locate to a screen column and row
 	 *
@@ -86,6 +131,9 @@ public:
 	/** Clear the screen and locate to 0,0 */
 	void cls();
 
+	/** Send the cells changed since the last flush to the panel */
+	void flush();
+
 	void setCursor( int value );
 
 	void moveCursor( int column, int row );
@@ -95,6 +143,31 @@ public:
 	int rows();
 	int columns();
 
+	/** Queue bus writes and send them from a timer interrupt
+	 *
+	 * @param value 1 to queue writes, 0 to write them synchronously again;
+	 *              switching to 0 waits for the queue to drain
+	 */
+	void setAsync( int value );
+
+	/** Returns 1 while queued writes are still being sent */
+	int busy();
+
+	/** Wait until every queued write has reached the panel */
+	void waitIdle();
+
+	/** Number of command bytes sent or queued since construction */
+	unsigned int commandCount();
+
+	/** Number of data (character) bytes sent or queued since construction */
+	unsigned int dataCount();
+
+	/** Call fptr from the timer interrupt each time the queue drains
+	 *
+	 * @param fptr Completion callback, or NULL to remove it
+	 */
+	void attach( void ( *fptr )( void ) );
+
 protected:
 
 	// Stream implementation functions
@@ -103,9 +176,14 @@ protected:
 
 	int address( int column, int row );
 	void character( int column, int row, int c );
+	bool writeDirty();
+	void writeRun( int column, int row, int end );
 	void writeByte( int value );
+	void printDashes( int width );
 	void writeCommand( int command );
 	void writeData( int data );
+	void queueByte( uint16_t entry );
+	void clock();
 
 	DigitalOut _rs, _e;
 	BusOut _d;
@@ -113,6 +191,27 @@ protected:
 
 	int _column;
 	int _row;
+	unsigned int _commands;
+	unsigned int _data;
+	int _cursorColumn;
+	int _cursorRow;
+
+	// Shadow of the largest panel; bit n of _dirty[row] marks column n
+	char _frame[4][20];
+	uint32_t _dirty[4];
+
+	// Async transmit: bits 0-7 byte, TX_RS data write, TX_SLOW 1.64ms command
+	enum {
+		TX_RS = 0x100,
+		TX_SLOW = 0x200
+	};
+	SpscQueue<uint16_t, 128> _tx;
+	Timeout _tick;
+	int _async;
+	volatile bool _running;
+	int _phase;
+	uint16_t _entry;
+	void ( *_idle )( void );
 };
 
 #endif
@@ -0,0 +1,68 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HOST_BENCH_H
+#define HOST_BENCH_H
+
+/*
+ * Host benchmark helpers. Every result is printed as one line
+ *
+ *     <metric> <value>
+ *
+ * so the output can be compared against bench/baseline.txt by a script.
+ * Rates are measured on the host CPU against the PWM1 model: they track
+ * relative changes in the driver, not the cycle cost on the LPC1768.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+static inline uint64_t bench_now_ns( void ) {
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline void bench_result( const char* metric, double value ) {
+	printf( "%s %.6g\n", metric, value );
+}
+
+// Run 'op' (an expression using the loop counter bench_i) 'count' times and
+// print <name>.ops_per_s and <name>.ns_per_op; the best of three runs is kept
+#define BENCH_RATE( name, count, op ) BENCH_RATE_N( name, count, 1, op )
+
+// As BENCH_RATE, for an 'op' that performs 'per_op' operations
+#define BENCH_RATE_N( name, count, per_op, op ) do { \
+		uint64_t bench_best = UINT64_MAX; \
+		for ( int bench_run = 0; bench_run < 3; bench_run++ ) { \
+			uint64_t bench_start = bench_now_ns(); \
+			for ( uint32_t bench_i = 0; bench_i < ( uint32_t )( count ); bench_i++ ) { \
+				op; \
+			} \
+			uint64_t bench_time = bench_now_ns() - bench_start; \
+			if ( bench_time < bench_best ) { \
+				bench_best = bench_time; \
+			} \
+		} \
+		if ( bench_best == 0 ) { \
+			bench_best = 1; \
+		} \
+		double bench_ops = ( double )( count ) * ( per_op ); \
+		bench_result( name ".ops_per_s", bench_ops * 1e9 / ( double )bench_best ); \
+		bench_result( name ".ns_per_op", ( double )bench_best / bench_ops ); \
+	} while ( 0 )
+
+#endif
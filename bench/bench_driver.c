@@ -0,0 +1,53 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * Throughput of the double edge driver setters against the PWM1 model.
+ * The model is not run while timing: each call only updates the driver
+ * cache and the register file, as on the part between two period starts.
+ */
+#include "pwmdoubleout_api.h"
+#include "pwm1_sim.h"
+#include "bench.h"
+
+#define OPS 1000000
+
+// keeps the read loops from being optimised away
+volatile float bench_sink;
+
+int main( void ) {
+	pwmdoubleout_t a;
+	pwmdoubleout_t b;
+	pwm1_sim_reset();
+	pwmdoubleout_init( &a, p25 );
+	pwmdoubleout_init( &b, p23 );
+	pwmdoubleout_set_freq( NULL, 192 );
+	pwm1_sim_run( 1000 );
+
+	BENCH_RATE( "driver.set_duty_cycle", OPS, pwmdoubleout_set_duty_cycle( &a, bench_i % 193 ) );
+	BENCH_RATE( "driver.set_dephase", OPS, pwmdoubleout_set_dephase( &a, bench_i % 192 ) );
+	BENCH_RATE( "driver.set_edges", OPS, pwmdoubleout_set_edges( &a, bench_i % 192, bench_i % 97 ) );
+	// fixed point against float; the host has an FPU, so the float rows
+	// understate the soft-float cost on the Cortex-M3
+	BENCH_RATE( "driver.write", OPS, pwmdoubleout_write( &a, ( bench_i & 0xff ) * ( 1.0f / 256 ) ) );
+	BENCH_RATE( "driver.write_q16", OPS, pwmdoubleout_write_q16( &a, ( bench_i & 0xff ) << 8 ) );
+	BENCH_RATE( "driver.dephase", OPS, pwmdoubleout_dephase( &a, ( bench_i & 0xff ) * ( 1.0f / 256 ) ) );
+	BENCH_RATE( "driver.dephase_q16", OPS, pwmdoubleout_dephase_q16( &a, ( bench_i & 0xff ) << 8 ) );
+	BENCH_RATE( "driver.read", OPS, bench_sink += pwmdoubleout_read( &a ) );
+	BENCH_RATE( "driver.read_q16", OPS, bench_sink += pwmdoubleout_read_q16( &a ) );
+	BENCH_RATE( "driver.set_freq", OPS, pwmdoubleout_set_freq( NULL, 100 + bench_i % 100 ) );
+	BENCH_RATE( "driver.retune", OPS, pwmdoubleout_retune( NULL, 100 + bench_i % 100 ) );
+	return 0;
+}
@@ -0,0 +1,57 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * Cost of formatting one front panel row into the TextLCD framebuffer:
+ * the integer helpers against snprintf() with the float conversion they
+ * replaced. The duty cycle changes every row so the digits are never
+ * the same twice in a row.
+ */
+#include "TextLCD.h"
+#include "bench.h"
+
+#define ROWS 1000000
+
+int main() {
+	TextLCD lcd( p15, p16, p17, p18, p19, p20, TextLCD::LCD20x4 );
+
+	BENCH_RATE( "format.helpers", ROWS, {
+		uint32_t duty = bench_i % 193;
+		lcd.locate( 0, 0 );
+		lcd.printString( "dA:<" );
+		lcd.printInt( duty, 5 );
+		lcd.printString( ">=" );
+		lcd.printTenths( duty, 192, 4 );
+		lcd.printString( "%" );
+	} );
+	BENCH_RATE( "format.printf_float", ROWS, {
+		uint32_t duty = bench_i % 193;
+		char row[24];
+		snprintf( row, sizeof( row ), "dA:<%05u>=%04.1f%%", ( unsigned )duty, 100.0f * duty / 192 );
+		lcd.locate( 0, 0 );
+		lcd.printString( row );
+	} );
+	BENCH_RATE( "format.khz.helpers", ROWS, {
+		lcd.locate( 11, 3 );
+		lcd.printKhz( 1 + bench_i % 3000, 96000, 4 );
+	} );
+	BENCH_RATE( "format.khz.printf", ROWS, {
+		char khz[12];
+		snprintf( khz, sizeof( khz ), "%04u", ( unsigned )( 96000 / ( 1 + bench_i % 3000 ) ) );
+		lcd.locate( 11, 3 );
+		lcd.printString( khz );
+	} );
+	return 0;
+}
@@ -0,0 +1,82 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * Cost of one PWM1 period interrupt with each of the handlers the driver
+ * attaches, called back to back: the dispatcher alone, bursts counting
+ * down on one and three channels and changing state every period, dither
+ * on three channels and a duty ramp. On the part the handler has to finish
+ * well inside the shortest period in use; CYCLE_PROBE_PWM_IRQ times it there.
+ */
+#include "PwmDoubleOut.h"
+#include "PwmDoubleRamp.h"
+#include "pwm1_sim.h"
+#include "bench.h"
+
+using namespace mbed;
+
+extern "C" void PWM1_IRQHandler( void );
+
+#define OPS 1000000
+#define ONE ( 1 << PWMDOUBLEOUT_DITHER_BITS )
+
+static void idle( uintptr_t id ) {
+	( void )id;
+}
+
+int main() {
+	pwm1_sim_reset();
+	PwmDoubleOut a( p25 );
+	PwmDoubleOut b( p23 );
+	PwmDoubleOut c( p21 );
+	a.set_freq( 192 );
+	a.set_edges( 10, 96 );
+	b.set_edges( 40, 96 );
+	c.set_edges( 70, 96 );
+	pwm1_sim_run( 1000 );
+
+	pwmdoubleout_irq_attach( &idle, 0 );
+	BENCH_RATE( "irq.empty", OPS, PWM1_IRQHandler() );
+	pwmdoubleout_irq_detach( &idle, 0 );
+
+	// long enough not to end while timed
+	a.burst( 4 * OPS );
+	BENCH_RATE( "irq.burst_1", OPS, PWM1_IRQHandler() );
+	b.burst( 4 * OPS );
+	c.burst( 4 * OPS );
+	BENCH_RATE( "irq.burst_3", OPS, PWM1_IRQHandler() );
+	b.burst_stop();
+	c.burst_stop();
+	// one pulse, one idle period: new edges every interrupt
+	a.burst( 1, 1 );
+	BENCH_RATE( "irq.burst_1.pulse", OPS, PWM1_IRQHandler() );
+	a.burst_stop();
+
+	a.dither( 10 * ONE + 77, 96 * ONE + 13 );
+	b.dither( 40 * ONE + ONE / 2, 96 * ONE + 200 );
+	c.dither( 70 * ONE + 1, 96 * ONE + 99 );
+	BENCH_RATE( "irq.dither_3", OPS, PWM1_IRQHandler() );
+	a.dither_stop();
+	b.dither_stop();
+	c.dither_stop();
+
+	PwmDoubleRamp ramp( a, PwmDoubleRamp::DUTY );
+	ramp.start( 180, 4 * OPS );
+	BENCH_RATE( "irq.ramp", OPS, PWM1_IRQHandler() );
+	ramp.cancel();
+
+	bench_result( "irq.overruns", pwmdoubleout_irq_overruns() );
+	return 0;
+}
@@ -0,0 +1,60 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * Bus traffic of the LCD front panel, counted on the HD44780 model: E
+ * strobes (nibbles), instruction and data bytes for the first paint of
+ * the four parameter rows, for a repaint where one digit changed and for
+ * one where nothing did. Each row is written with locate() and printf(),
+ * as the panel code did before the framebuffer.
+ */
+#include "TextLCD.h"
+#include "hd44780_sim.h"
+#include "bench.h"
+
+static void paint( TextLCD& lcd, uint32_t duty ) {
+	lcd.locate( 0, 0 );
+	lcd.printf( "dA:<%05u>=%04.1f%%", ( unsigned )duty, 100.0 * duty / 192 );
+	lcd.locate( 0, 1 );
+	lcd.printf( "dB:<%05u>=%04.1f%%", 96u, 50.0 );
+	lcd.locate( 0, 2 );
+	lcd.printf( "Ph:<%05u>=%04.1f%%", 48u, 25.0 );
+	lcd.locate( 0, 3 );
+	lcd.printf( "Fq:<%05u>=%04uKHz", 192u, 500u );
+}
+
+static void traffic( const char* name, TextLCD& lcd, uint32_t duty ) {
+	uint32_t nibbles = hd44780_sim_nibbles();
+	uint32_t commands = hd44780_sim_commands();
+	uint32_t data = hd44780_sim_data();
+	paint( lcd, duty );
+	char metric[48];
+	snprintf( metric, sizeof( metric ), "lcd.%s.nibbles", name );
+	bench_result( metric, hd44780_sim_nibbles() - nibbles );
+	snprintf( metric, sizeof( metric ), "lcd.%s.commands", name );
+	bench_result( metric, hd44780_sim_commands() - commands );
+	snprintf( metric, sizeof( metric ), "lcd.%s.data", name );
+	bench_result( metric, hd44780_sim_data() - data );
+}
+
+int main() {
+	hd44780_sim_attach( p15, p16, p17, p18, p19, p20 );
+	TextLCD lcd( p15, p16, p17, p18, p19, p20, TextLCD::LCD20x4 );
+
+	traffic( "paint", lcd, 96 );
+	traffic( "one_digit", lcd, 97 );
+	traffic( "unchanged", lcd, 97 );
+	return 0;
+}
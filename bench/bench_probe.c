@@ -0,0 +1,39 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * What an enabled probe adds to the code it brackets: one
+ * CYCLE_PROBE_BEGIN/END pair around nothing, and its two halves. On the
+ * host both halves read the monotonic clock; on the target they are one
+ * DWT_CYCCNT load each, so only the relative cost carries over.
+ */
+#define CYCLE_PROBE 1
+#include "cycle_probe.h"
+#include "bench.h"
+
+#define PAIRS 10000000
+
+static volatile uint32_t bench_sink;
+
+int main( void ) {
+	cycle_probe_init();
+	BENCH_RATE( "probe.pair", PAIRS, {
+		CYCLE_PROBE_BEGIN( CYCLE_PROBE_TRIGGER );
+		CYCLE_PROBE_END( CYCLE_PROBE_TRIGGER );
+	} );
+	BENCH_RATE( "probe.now", PAIRS, bench_sink = cycle_probe_now() );
+	BENCH_RATE( "probe.record", PAIRS, cycle_probe_record( CYCLE_PROBE_APPLY, bench_i & 0xfff ) );
+	return 0;
+}
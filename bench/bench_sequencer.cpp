@@ -0,0 +1,66 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * Sustained sequencer throughput: entries pushed by the producer and
+ * loaded by the period interrupt per second, first with the interrupt
+ * handler called back to back, then with the PWM1 model running a 48 tick
+ * period (2 MHz at 96 MHz) between entries.
+ */
+#include "PwmDoubleOut.h"
+#include "PwmDoubleSequencer.h"
+#include "pwm1_sim.h"
+#include "bench.h"
+
+using namespace mbed;
+
+extern "C" void PWM1_IRQHandler( void );
+
+#define ENTRIES 1000000
+#define RING 64
+
+int main() {
+	static PwmDoubleStep ring[RING];
+	static PwmDoubleStep steps[RING];
+	pwm1_sim_reset();
+	PwmDoubleOut a( p25 );
+	PwmDoubleOut b( p23 );
+	a.set_freq( 48 );
+	pwm1_sim_run( 1000 );
+	for ( uint32_t k = 0; k < RING; k++ ) {
+		steps[k].mask = 0x1f;
+		steps[k].match[0] = 48;
+		steps[k].match[1] = k % 48;
+		steps[k].match[2] = ( k * 7 ) % 48;
+		steps[k].match[3] = ( k * 3 ) % 48;
+		steps[k].match[4] = ( k * 5 ) % 48;
+	}
+
+	PwmDoubleSequencer seq( ring, RING );
+	seq.start();
+	BENCH_RATE_N( "sequencer.isr", ENTRIES / RING, RING, {
+		seq.push( steps, RING );
+		for ( uint32_t k = 0; k < RING; k++ ) {
+			PWM1_IRQHandler();
+		}
+	} );
+	BENCH_RATE_N( "sequencer.sim", ENTRIES / RING / 10, RING, {
+		seq.push( steps, RING );
+		pwm1_sim_run( 48 * RING );
+	} );
+	seq.stop();
+	bench_result( "sequencer.underruns", seq.underruns() );
+	return 0;
+}
@@ -0,0 +1,171 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * The front panel logic of main.cpp on the host models: encoder edges go
+ * through the pin interrupt into trigger(), the main loop side is
+ * applyCommands(), and the repaint goes through printRow() to the HD44780
+ * model. main() itself never returns, so it is renamed away and its
+ * set-up and repaint are repeated here.
+ */
+#include "hd44780_sim.h"
+
+// before main.cpp, so the panel model sees the LCD initialisation
+static int lcd_attached = ( hd44780_sim_attach( p15, p16, p17, p18, p19, p20 ), 1 );
+
+#define main app_main
+#include "main.cpp"
+#undef main
+
+#include "bench.h"
+
+// One detent forward (state A << 1 | B: 11 -> 10 -> 00 -> 01 -> 11) or back
+static void detent( int dir ) {
+	if ( dir > 0 ) {
+		mbed_sim_pin_write( p13, 0 );
+		mbed_sim_pin_write( p14, 0 );
+		mbed_sim_pin_write( p13, 1 );
+		mbed_sim_pin_write( p14, 1 );
+	} else {
+		mbed_sim_pin_write( p14, 0 );
+		mbed_sim_pin_write( p13, 0 );
+		mbed_sim_pin_write( p14, 1 );
+		mbed_sim_pin_write( p13, 1 );
+	}
+}
+
+static void setup() {
+	WaveConfig cfg = { FREQ_INIT, DUTY_CYCLE_INIT, DUTY_CYCLE_INIT, DEPHASE_INIT };
+	waveConfig = cfg;
+	FQ_INC.store( 1 );
+	DA_INC.store( 1 );
+	DB_INC.store( 1 );
+	PH_INC.store( 1 );
+	{
+		PwmDoubleGroup group;
+		waveB.set_freq( cfg.freq );
+		waveA.set_duty_cycle( cfg.dutyA );
+		waveB.set_duty_cycle( cfg.dutyB );
+		waveB.set_dephase( cfg.dephase );
+	}
+	setIrqPriorities();
+	decoder.reset( knob.read(), decoderIn.read() );
+	// slow turns only: one step per detent
+	decoder.set_acceleration( 0, 1 );
+	knob.rise( &trigger );
+	knob.fall( &trigger );
+	decoderIn.rise( &trigger );
+	decoderIn.fall( &trigger );
+	lcd.setCursor( TRUE );
+	lcd.setAsync( TRUE );
+	for ( uint32_t r = 0; r < 4; r++ ) {
+		printRow( r, waveConfig );
+	}
+	lcd.moveCursor( COL_OFFSET + 4, 0 );
+	row.store( 0 );
+}
+
+// The tail of the main loop: repaint the changed rows, put the cursor back
+// and let the timer interrupt clock everything out
+static void repaint( uint8_t flag ) {
+	for ( uint32_t r = 0; r < 4; r++ ) {
+		if ( flag & ( 1 << r ) ) {
+			printRow( r, waveConfig );
+		}
+	}
+	lcd.moveCursor( COL_OFFSET + 4, row.load() );
+	while ( lcd.busy() ) {
+		mbed_sim_run_us( 1000 );
+	}
+}
+
+static bool shown( uint8_t address, const char* expected ) {
+	char text[21];
+	hd44780_sim_read( address, text, 20 );
+	if ( strcmp( text, expected ) != 0 ) {
+		printf( "panel shows \"%s\", expected \"%s\"\n", text, expected );
+		return false;
+	}
+	return true;
+}
+
+// Panel traffic of one detent on 'param', from the edges to the last nibble
+static void repaint_traffic( const char* name, uint32_t param ) {
+	row.store( param );
+	uint32_t nibbles = hd44780_sim_nibbles();
+	uint32_t commands = lcd.commandCount();
+	uint32_t data = lcd.dataCount();
+	detent( 1 );
+	repaint( applyCommands() );
+	char metric[48];
+	snprintf( metric, sizeof( metric ), "ui.repaint_%s.nibbles", name );
+	bench_result( metric, hd44780_sim_nibbles() - nibbles );
+	snprintf( metric, sizeof( metric ), "ui.repaint_%s.commands", name );
+	bench_result( metric, lcd.commandCount() - commands );
+	snprintf( metric, sizeof( metric ), "ui.repaint_%s.data", name );
+	bench_result( metric, lcd.dataCount() - data );
+}
+
+int main() {
+	( void )lcd_attached;
+	setup();
+	while ( lcd.busy() ) {
+		mbed_sim_run_us( 1000 );
+	}
+
+	// duty A 96 -> 97 ticks: one row; frequency 192 -> 193: every row
+	repaint_traffic( "duty", 0 );
+	repaint_traffic( "freq", 3 );
+	// traffic that does not reach the panel right is no measurement
+	if ( !shown( 0x00, "dA:<00097>=50.3%    " ) || !shown( 0x54, "Fq:<00193>=0497KHz  " ) ) {
+		return 1;
+	}
+	row.store( 0 );
+
+	// duty cycle A back and forth by one tick: four edges, one command,
+	// one register commit
+	BENCH_RATE( "ui.edge_to_commit", 1000000, {
+		detent( ( bench_i & 1 ) ? -1 : 1 );
+		applyCommands();
+	} );
+
+	// latency as main.cpp records it, with the loop reaching
+	// applyCommands() 'poll' us after the last edge
+	static const uint32_t POLL_US[] = { 0, 50, 1000 };
+	for ( uint32_t p = 0; p < sizeof( POLL_US ) / sizeof( POLL_US[0] ); p++ ) {
+		edgeLatencyMaxUs.store( 0 );
+		for ( int k = 0; k < 100; k++ ) {
+			detent( ( k & 1 ) ? -1 : 1 );
+			mbed_sim_run_us( POLL_US[p] );
+			applyCommands();
+		}
+		char metric[48];
+		snprintf( metric, sizeof( metric ), "ui.edge_latency_us.poll_%u", ( unsigned )POLL_US[p] );
+		bench_result( metric, edgeLatencyMaxUs.load() );
+	}
+	// a burst of detents with the main loop stalled: the queue holds what
+	// it can, the rest is counted
+	for ( int k = 0; k < 20; k++ ) {
+		detent( 1 );
+	}
+	applyCommands();
+	bench_result( "ui.lost_commands", lostCommands.load() );
+	// lower is more urgent
+	bench_result( "ui.irq_priority.pwm1", NVIC_GetPriority( PWM1_IRQn ) );
+	bench_result( "ui.irq_priority.eint3", NVIC_GetPriority( EINT3_IRQn ) );
+	bench_result( "ui.irq_priority.timer3", NVIC_GetPriority( TIMER3_IRQn ) );
+	printStats();
+	return 0;
+}
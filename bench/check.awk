@@ -0,0 +1,43 @@
+# Compare benchmark output with bench/baseline.txt
+#
+#   awk -v tolerance=0.5 -f bench/check.awk bench/baseline.txt results.txt
+#
+# Prints one line per baseline metric and exits non zero if any metric
+# regressed or is missing from the results.
+
+FNR == NR {
+	if ( $0 !~ /^#/ && NF == 3 ) {
+		order[count++] = $1
+		kind[$1] = $2
+		base[$1] = $3
+	}
+	next
+}
+
+NF == 2 && ( $1 in kind ) {
+	value[$1] = $2
+}
+
+END {
+	failed = 0
+	for ( i = 0; i < count; i++ ) {
+		metric = order[i]
+		if ( !( metric in value ) ) {
+			printf "%-36s %-3s %10g %10s MISSING\n", metric, kind[metric], base[metric], "-"
+			failed++
+			continue
+		}
+		v = value[metric] + 0
+		b = base[metric] + 0
+		if ( kind[metric] == "max" ) {
+			ok = v <= b * ( 1 + tolerance )
+		} else {
+			ok = v == b
+		}
+		printf "%-36s %-3s %10g %10g %s\n", metric, kind[metric], b, v, ok ? "ok" : "REGRESSED"
+		if ( !ok ) {
+			failed++
+		}
+	}
+	exit failed != 0
+}
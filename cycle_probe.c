@@ -0,0 +1,98 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cycle_probe.h"
+#include "cmsis.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef PWM1_SIM
+#include <time.h>
+#endif
+
+#define DEMCR_TRCENA     0x01000000
+#define DWT_CTRL_CYCCNT  0x00000001
+
+static const char* const cycle_probe_names[CYCLE_PROBE_COUNT] = {
+	"trigger", "apply", "pwm_edges", "pwm_duty", "pwm_period", "pwm_irq",
+	"lcd_row"
+};
+
+static cycle_probe_stats cycle_probe_table[CYCLE_PROBE_COUNT];
+
+void cycle_probe_init( void ) {
+	// enable only: the PWM period interrupt counts elapsed periods from
+	// the running count, a reset under it would read as billions of them
+	CoreDebug->DEMCR |= DEMCR_TRCENA;
+	DWT->CTRL |= DWT_CTRL_CYCCNT;
+	cycle_probe_reset();
+}
+
+void cycle_probe_reset( void ) {
+	memset( cycle_probe_table, 0, sizeof( cycle_probe_table ) );
+	for ( int id = 0; id < CYCLE_PROBE_COUNT; id++ ) {
+		cycle_probe_table[id].min = UINT32_MAX;
+	}
+}
+
+uint32_t cycle_probe_now( void ) {
+#ifdef PWM1_SIM
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ( uint32_t )( ts.tv_sec * 1000000000ull + ts.tv_nsec );
+#else
+	return DWT->CYCCNT;
+#endif
+}
+
+void cycle_probe_record( cycle_probe_id id, uint32_t cycles ) {
+	cycle_probe_stats* stats = &cycle_probe_table[id];
+	stats->count++;
+	stats->total += cycles;
+	if ( cycles < stats->min ) {
+		stats->min = cycles;
+	}
+	if ( cycles > stats->max ) {
+		stats->max = cycles;
+	}
+	// floor( log2( cycles ) ), 0 for 0 and 1
+	int bucket = ( cycles > 1 ) ? 31 - __builtin_clz( cycles ) : 0;
+	if ( bucket >= CYCLE_PROBE_BUCKETS ) {
+		bucket = CYCLE_PROBE_BUCKETS - 1;
+	}
+	stats->histogram[bucket]++;
+}
+
+const cycle_probe_stats* cycle_probe_get( cycle_probe_id id ) {
+	return &cycle_probe_table[id];
+}
+
+void cycle_probe_dump( void ) {
+	for ( int id = 0; id < CYCLE_PROBE_COUNT; id++ ) {
+		const cycle_probe_stats* stats = &cycle_probe_table[id];
+		if ( stats->count == 0 ) {
+			continue;
+		}
+		printf( "%-10s n=%lu min=%lu avg=%lu max=%lu |",
+		        cycle_probe_names[id], ( unsigned long )stats->count,
+		        ( unsigned long )stats->min,
+		        ( unsigned long )( stats->total / stats->count ),
+		        ( unsigned long )stats->max );
+		for ( int bucket = 0; bucket < CYCLE_PROBE_BUCKETS; bucket++ ) {
+			printf( " %lu", ( unsigned long )stats->histogram[bucket] );
+		}
+		printf( "\n" );
+	}
+}
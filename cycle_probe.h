@@ -0,0 +1,98 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_CYCLE_PROBE_H
+#define MBED_CYCLE_PROBE_H
+
+#include <stdint.h>
+
+/* Cycle count probes around hot paths
+ *
+ * Build with -DCYCLE_PROBE=1 to enable them. Otherwise CYCLE_PROBE_BEGIN()
+ * and CYCLE_PROBE_END() expand to nothing and no probe code is linked in.
+ *
+ *     CYCLE_PROBE_BEGIN( CYCLE_PROBE_LCD_ROW );
+ *     print_row();
+ *     CYCLE_PROBE_END( CYCLE_PROBE_LCD_ROW );
+ *
+ * On the target the DWT cycle counter is used, under PWM1_SIM the host
+ * monotonic clock in ns. A probe must only be recorded from one context
+ * (thread or interrupt), since the statistics are updated without locking.
+ * The pwm_* setter probes therefore belong to the main loop: code running
+ * from the PWM1 interrupt uses the pwmdoubleout_store_* paths, which are
+ * not probed, and is timed as a whole by CYCLE_PROBE_PWM_IRQ.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	CYCLE_PROBE_TRIGGER,     // encoder edge interrupt (GPIO interrupt)
+	CYCLE_PROBE_APPLY,       // command batch applied to the PWM (main)
+	CYCLE_PROBE_PWM_EDGES,   // pwmdoubleout_set_edges() (main)
+	CYCLE_PROBE_PWM_DUTY,    // pwmdoubleout_set_duty_cycle() (main)
+	CYCLE_PROBE_PWM_PERIOD,  // pwmdoubleout_set_freq() and retune() (main)
+	CYCLE_PROBE_PWM_IRQ,     // PWM1 period interrupt, all handlers (PWM1 interrupt)
+	CYCLE_PROBE_LCD_ROW,     // one LCD row repaint (main)
+	CYCLE_PROBE_COUNT
+} cycle_probe_id;
+
+#define CYCLE_PROBE_BUCKETS 16
+
+typedef struct {
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t total;
+	// bucket n counts samples in [2^n, 2^(n+1)), the last one everything above
+	uint32_t histogram[CYCLE_PROBE_BUCKETS];
+} cycle_probe_stats;
+
+#if CYCLE_PROBE
+
+#define CYCLE_PROBE_BEGIN( id )  uint32_t cycle_probe_start_##id = cycle_probe_now()
+#define CYCLE_PROBE_END( id )    cycle_probe_record( id, cycle_probe_now() - cycle_probe_start_##id )
+
+#else
+
+#define CYCLE_PROBE_BEGIN( id )
+#define CYCLE_PROBE_END( id )
+
+#endif
+
+/** Enable the cycle counter, without resetting it, and clear every probe */
+void cycle_probe_init( void );
+
+/** Clear every probe */
+void cycle_probe_reset( void );
+
+/** Current cycle count, free running */
+uint32_t cycle_probe_now( void );
+
+/** Add one sample to a probe */
+void cycle_probe_record( cycle_probe_id id, uint32_t cycles );
+
+/** Statistics of one probe */
+const cycle_probe_stats* cycle_probe_get( cycle_probe_id id );
+
+/** printf one line per probe that has samples */
+void cycle_probe_dump( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -6,6 +6,10 @@
  */
 #include "TextLCD.h"
 #include "PwmDoubleOut.h"
+#include "PwmDoubleGroup.h"
+#include "SpscQueue.h"
+#include "QuadratureDecoder.h"
+#include "cycle_probe.h"
 /*
  * C++ lib for atomic operations
  */
@@ -38,23 +42,18 @@ static constexpr auto COL_OFFSET = 4; //first digit is at 4,Y
 static constexpr auto COL_LIM = 9; // 9th column is out of bounds
 
 /*
- * Strings format for printf
+ * Row labels and field widths on the LCD: "dA:<00096>=50.0%"
  */
 
-#define DA_PRINT "dA:<%05d>"
-#define DB_PRINT "dB:<%05d>"
-#define PH_PRINT "Ph:<%05d>"
-#define FQ_PRINT "Fq:<%05d>"
-#define DA_REF_PRINT "=%04.1f%%"
-#define DB_REF_PRINT "=%04.1f%%"
-#define PH_REF_PRINT "=%04.1f%%"
-#define FQ_REF_PRINT "=%04dKHz"
+static const char* const ROW_LABEL[4] = { "dA:<", "dB:<", "Ph:<", "Fq:<" };
+static constexpr auto VALUE_DIGITS = 5;
+static constexpr auto REF_DIGITS = 4;
 
 #define TRUE 1
 #define FALSE 0
 
 InterruptIn knob( p14 );
-DigitalIn decoderIn( p13 );
+InterruptIn decoderIn( p13 );
 
 PwmDoubleOut waveB ( p23 );
 PwmDoubleOut waveA ( p25 );
@@ -69,23 +68,26 @@ DigitalIn colinc( p11 );
 
 TextLCD lcd( p15, p16, p17, p18, p19, p20 , TextLCD::LCD20x4 );
 
-std::atomic<uint32_t> freqKhz;
-std::atomic<uint32_t> dutyCycleA;
-std::atomic<uint32_t> dutyCycleB;
-std::atomic<uint32_t> dephase;
-
 /*
- * Cursor control
+ * Wave parameters, in PWM ticks. Only the main loop reads and writes them;
+ * the encoder ISR posts commands instead.
  */
 
-std::atomic<uint32_t> row;
-std::atomic<uint32_t> col;
+struct WaveConfig {
+	uint32_t freq;
+	uint32_t dutyA;
+	uint32_t dutyB;
+	uint32_t dephase;
+};
+
+WaveConfig waveConfig;
 
 /*
- * LCD print control bit1-DA | bit2-DB | bit3-PH | bit4-FQ
+ * Cursor control
  */
 
-std::atomic<uint8_t> flagModified;
+std::atomic<uint32_t> row;
+std::atomic<uint32_t> col;
 
 /*
  * Unit of increment for each parameter.
@@ -96,106 +98,231 @@ std::atomic<uint32_t> DA_INC;
 std::atomic<uint32_t> DB_INC;
 std::atomic<uint32_t> PH_INC;
 
+static std::atomic<uint32_t>* const INC[4] = { &DA_INC, &DB_INC, &PH_INC, &FQ_INC };
+
+/*
+ * Commands posted by the encoder ISR and applied by the main loop
+ */
+
+enum CommandType {
+	CMD_DELTA // add delta to the parameter on row param
+};
+
+struct Command {
+	uint8_t type;
+	uint8_t param;
+	int32_t delta;
+	uint32_t edge; // us_ticker_read() at the encoder edge
+};
+
+SpscQueue<Command, 16> commands;
+std::atomic<uint32_t> lostCommands;
+
+/*
+ * Encoder decoding, p14 is line A and p13 line B
+ */
+
+QuadratureDecoder decoder;
+
+/*
+ * Time from the encoder edge to the PWM register commit, in us
+ */
+
+std::atomic<uint32_t> edgeLatencyUs;
+std::atomic<uint32_t> edgeLatencyMaxUs;
+
 /**
- * Functions that triggers via interrupt when the encoder is turned
+ * Repaints one parameter row from cfg
  */
 
-void trigger() {
-	int decoderMultiplier = 1;
-	//FInd out the way it is turning, so as to know wether to increment or decrement
-	if ( decoderIn.read() == 0 ) {
-		decoderMultiplier = -1;
+void printRow( uint32_t r, const WaveConfig& cfg ) {
+	static const uint32_t WaveConfig::* const VALUE[4] = {
+		&WaveConfig::dutyA, &WaveConfig::dutyB, &WaveConfig::dephase, &WaveConfig::freq
+	};
+	CYCLE_PROBE_BEGIN( CYCLE_PROBE_LCD_ROW );
+	lcd.locate( 0, r );
+	lcd.printString( ROW_LABEL[r] );
+	lcd.printInt( cfg.*VALUE[r], VALUE_DIGITS );
+	lcd.printString( ">=" );
+	if ( r == 3 ) {
+		lcd.printKhz( cfg.freq, pwmdoubleout_clock_hz() / 1000, REF_DIGITS );
+		lcd.printString( "KHz" );
+	} else {
+		lcd.printTenths( cfg.*VALUE[r], cfg.freq, REF_DIGITS );
+		lcd.printString( "%" );
 	}
+	CYCLE_PROBE_END( CYCLE_PROBE_LCD_ROW );
+}
+
+/**
+ * Adds delta to the parameter on row param of cfg and writes the PWM registers.
+ * Returns the LCD print control bits: bit1-DA | bit2-DB | bit3-PH | bit4-FQ
+ */
+
+uint8_t apply( WaveConfig& cfg, uint32_t param, int32_t delta ) {
 	//DIfferent case for each row (which represents each value)
 	uint8_t flag = 0;
-	switch ( row.load() ) {
+	int32_t fq = cfg.freq;
+	switch ( param ) {
 	case 0:	{
 		//DutyCycleA
-		int32_t dA = dutyCycleA.load();
-		dA += DA_INC.load() * decoderMultiplier;
-		int32_t fq = freqKhz.load();
+		int32_t dA = cfg.dutyA + delta;
 		//Make sure it stays inbound
 		if ( dA > fq ) {
 			dA = fq;
 		} else if ( dA < DUTY_CYCLE_MIN ) {
 			dA = DUTY_CYCLE_MIN;
 		}
-		dutyCycleA.store( dA );
+		cfg.dutyA = dA;
 		waveA.set_duty_cycle( dA );
 		flag |= ( 1 << 0 );
 		break;
 	}
 	case 1:	{
 		//DutyCycleB
-		int32_t dB = dutyCycleB.load();
-		dB += DB_INC.load() * decoderMultiplier;
-		int32_t fq = freqKhz.load();
+		int32_t dB = cfg.dutyB + delta;
 		if ( dB > fq ) {
 			dB = fq;
 		} else if ( dB < DUTY_CYCLE_MIN ) {
 			dB = DUTY_CYCLE_MIN;
 		}
-		dutyCycleB.store( dB );
+		cfg.dutyB = dB;
 		waveB.set_duty_cycle( dB );
 		flag |= ( 1 << 1 );
 		break;
 	}
 	case 2:	{
 		//dephase
-		int32_t ph = dephase.load();
-		ph += PH_INC.load() * decoderMultiplier;
-		int32_t fq = freqKhz.load();
-		if ( ph >= fq ) {
+		int32_t ph = cfg.dephase + delta;
+		if ( fq == 0 ) {
+			//no period to shift within (FREQ_MIN), and ph % fq would trap
+			ph = 0;
+		} else if ( ph >= fq ) {
 			ph = ph % fq;
 		} else if ( ph < DEPHASE_MIN ) {
 			ph = ( ph % fq ) * ( -1 );
 		}
-		dephase.store( ph );
+		cfg.dephase = ph;
 		waveB.set_dephase( ph );
 		flag |= ( 1 << 2 );
 		break;
 	}
 	case 3:	{
 		//Freq
-		int32_t fq = freqKhz.load();
-		int32_t old_fq = fq;
-		fq += FQ_INC.load() * decoderMultiplier;
+		fq += delta;
 		if ( fq > FREQ_MAX ) {
 			fq = FREQ_MAX;
 		} else if ( fq < FREQ_MIN ) {
 			fq = FREQ_MIN;
 		}
-		freqKhz.store( fq );
+		cfg.freq = fq;
+		//latch the new period and every channel on the same period start
+		PwmDoubleGroup group;
 		waveB.set_freq( fq );
 		//rewrite dutyCycles and dephase in order to maintain consistency
-		uint32_t dA = dutyCycleA.load();
-		if ( dA > fq ) {
-			dutyCycleA.store( fq );
-			dA = fq;
+		if ( cfg.dutyA > cfg.freq ) {
+			cfg.dutyA = cfg.freq;
 		}
-		uint32_t dB = dutyCycleB.load();
-		if ( dB > fq ) {
-			dutyCycleB.store( fq );
-			dB = fq;
+		if ( cfg.dutyB > cfg.freq ) {
+			cfg.dutyB = cfg.freq;
 		}
-		uint32_t ph = dephase.load();
-		if ( ph >= fq ) {
-			dephase.store( 0 );
-			ph = 0;
+		if ( cfg.dephase >= cfg.freq ) {
+			cfg.dephase = 0;
 		}
 
-		waveA.set_duty_cycle( dA );
-		waveB.set_dephase( ph );
-		waveB.set_duty_cycle( dB );
+		waveA.set_duty_cycle( cfg.dutyA );
+		waveB.set_dephase( cfg.dephase );
+		waveB.set_duty_cycle( cfg.dutyB );
 		flag |= 0x0F;
 		break;
 	}
 	}
-	//Debounce for encoder
-	flagModified.store( flag );
-	wait( 0.05f );
-	while ( knob.read() != 0 );
-	wait( 0.05f );
+	return flag;
+}
+
+/**
+ * Drains the command queue, merging all deltas on a parameter into one
+ * update and all updates into one register commit
+ */
+
+uint8_t applyCommands() {
+	int32_t delta[4] = { 0, 0, 0, 0 };
+	bool pending = false;
+	uint32_t edge = 0;
+	Command cmd;
+	while ( commands.pop( cmd ) ) {
+		if ( !pending ) {
+			edge = cmd.edge;
+			pending = true;
+		}
+		delta[cmd.param] += cmd.delta;
+	}
+	if ( !pending ) {
+		return 0;
+	}
+	CYCLE_PROBE_BEGIN( CYCLE_PROBE_APPLY );
+	uint8_t flag = 0;
+	{
+		PwmDoubleGroup group;
+		for ( uint32_t param = 0; param < 4; param++ ) {
+			if ( delta[param] != 0 ) {
+				flag |= apply( waveConfig, param, delta[param] );
+			}
+		}
+	}
+	CYCLE_PROBE_END( CYCLE_PROBE_APPLY );
+	//Oldest edge in the batch to register commit
+	uint32_t latency = us_ticker_read() - edge;
+	edgeLatencyUs.store( latency );
+	if ( latency > edgeLatencyMaxUs.load() ) {
+		edgeLatencyMaxUs.store( latency );
+	}
+	return flag;
+}
+
+/**
+ * Functions that triggers via interrupt on every edge of the encoder lines
+ */
+
+void trigger() {
+	CYCLE_PROBE_BEGIN( CYCLE_PROBE_TRIGGER );
+	uint32_t edge = us_ticker_read();
+	//Direction and acceleration come from the decoder; bounces cancel out
+	int32_t steps = decoder.edge( knob.read(), decoderIn.read(), edge );
+	if ( steps != 0 ) {
+		uint32_t param = row.load();
+		Command cmd = { CMD_DELTA, ( uint8_t )param,
+		                ( int32_t )INC[param]->load() * steps, edge
+		              };
+		if ( !commands.push( cmd ) ) {
+			lostCommands.fetch_add( 1 );
+		}
+	}
+	CYCLE_PROBE_END( CYCLE_PROBE_TRIGGER );
+}
+
+/**
+ * Prints the edge to commit latency, the commands dropped on a full queue
+ * and the LCD traffic on the serial port
+ */
+
+void printStats() {
+	printf( "edge latency us last=%u max=%u\n", ( unsigned )edgeLatencyUs.load(),
+	        ( unsigned )edgeLatencyMaxUs.load() );
+	printf( "lost commands=%u\n", ( unsigned )lostCommands.load() );
+	printf( "lcd commands=%u data=%u\n", lcd.commandCount(), lcd.dataCount() );
+	printf( "pwm overruns=%u\n", ( unsigned )pwmdoubleout_irq_overruns() );
+}
+
+/**
+ * The PWM1 period interrupt must not wait for the encoder lines (EINT3) or
+ * the LCD writes (TIMER3, the us ticker behind Timeout), else bursts,
+ * dither and ramps lose periods: both are put below it
+ */
+void setIrqPriorities() {
+	NVIC_SetPriority( PWM1_IRQn, PWMDOUBLEOUT_IRQ_PRIORITY );
+	NVIC_SetPriority( EINT3_IRQn, PWMDOUBLEOUT_IRQ_PRIORITY + 1 );
+	NVIC_SetPriority( TIMER3_IRQn, PWMDOUBLEOUT_IRQ_PRIORITY + 1 );
 }
 
 /**
@@ -209,43 +336,44 @@ void debounce( DigitalIn in ) {
 }
 
 int main() {
-	//Initialize modified flag
-	flagModified.store( FALSE );
+#if CYCLE_PROBE
+	cycle_probe_init();
+#endif
 	//Set buttons mode as pullUp
 	rowinc.mode( PullUp );
 	rowdec.mode( PullUp );
 	colinc.mode( PullUp );
 	coldec.mode( PullUp );
-	//Initialize the atomic values
-	freqKhz.store( FREQ_INIT );
-	dutyCycleA.store( DUTY_CYCLE_INIT );
-	dutyCycleB.store( DUTY_CYCLE_INIT );
-	dephase.store( DEPHASE_INIT );
+	//Initialize the wave parameters
+	WaveConfig cfg = { FREQ_INIT, DUTY_CYCLE_INIT, DUTY_CYCLE_INIT, DEPHASE_INIT };
+	waveConfig = cfg;
 	//Initialize the increment values
 	FQ_INC.store( 1 );
 	DA_INC.store( 1 );
 	DB_INC.store( 1 );
 	PH_INC.store( 1 );
 	//Initializing waves
-	waveB.set_freq( freqKhz.load() );
-	waveA.set_duty_cycle( dutyCycleA.load() );
-	waveB.set_duty_cycle( dutyCycleB.load() );
-	waveB.set_dephase( dephase.load() );
-	//Setting up the interrupt on the encoder
+	{
+		PwmDoubleGroup group;
+		waveB.set_freq( cfg.freq );
+		waveA.set_duty_cycle( cfg.dutyA );
+		waveB.set_duty_cycle( cfg.dutyB );
+		waveB.set_dephase( cfg.dephase );
+	}
+	//Setting up the interrupts on both encoder lines
+	setIrqPriorities();
+	decoder.reset( knob.read(), decoderIn.read() );
 	knob.rise( &trigger );
+	knob.fall( &trigger );
+	decoderIn.rise( &trigger );
+	decoderIn.fall( &trigger );
 	//Seeting up the LCD
 	lcd.setCursor( TRUE );
-	uint32_t dA = dutyCycleA.load();
-	uint32_t dB = dutyCycleB.load();
-	uint32_t ph = dephase.load();
-	uint32_t fq = freqKhz.load();
-	lcd.printf(
-	    DA_PRINT DA_REF_PRINT "\n" DB_PRINT DB_REF_PRINT "\n" PH_PRINT
-	    PH_REF_PRINT "\n" FQ_PRINT FQ_REF_PRINT,
-	    dA , 100 * ( ( float )dA / fq ),
-	    dB , 100 * ( ( float )dB / fq ),
-	    ph , 100 * ( ( float )ph / fq ),
-	    fq , 96000 / fq );
+	//From here on the LCD is written from a timer interrupt
+	lcd.setAsync( TRUE );
+	for ( uint32_t r = 0; r < 4; r++ ) {
+		printRow( r, cfg );
+	}
 	lcd.moveCursor( COL_OFFSET + 4, 0 );
 	//Initializing rows and collumns
 	row.store( 0 );
@@ -256,6 +384,16 @@ int main() {
 	 * Main loop. Check if any button is pushed in order to modify row/collumn
 	 */
 	while ( 1 ) {
+		//Both row buttons held: print the statistics
+		if ( rowinc.read() == 0 && rowdec.read() == 0 ) {
+#if CYCLE_PROBE
+			cycle_probe_dump();
+#endif
+			printStats();
+			debounce( rowinc );
+			debounce( rowdec );
+			continue;
+		}
 		if ( rowinc.read() == 0 ) {
 			uint32_t temp = row.load();
 			temp = ( temp + 1 ) % 4;
@@ -338,33 +476,13 @@ int main() {
 			debounce( coldec );
 		}
 		// If there was any modification to any wave, the LCD will be updated.
-		uint8_t flag = flagModified.load();
+		uint8_t flag = applyCommands();
 		if ( flag ) {
-			flagModified.store( FALSE );
-			//Since everything is rewritten, the cls() might be unneccessary
-			uint32_t fq = freqKhz.load();
-			if ( flag & ( 1 << 0 ) ) {
-				//PRINT DA
-				lcd.locate( 0, 0 );
-				uint32_t dA = dutyCycleA.load();
-				lcd.printf( DA_PRINT DA_REF_PRINT, dA, 100 * ( ( float )dA / fq ) );
-			}
-			if ( flag & ( 1 << 1 ) ) {
-				//PRINT DB
-				uint32_t dB = dutyCycleB.load();
-				lcd.locate( 0, 1 );
-				lcd.printf( DB_PRINT DB_REF_PRINT, dB, 100 * ( ( float )dB / fq ) );
-			}
-			if ( flag & ( 1 << 2 ) ) {
-				//PRINT PH
-				uint32_t ph = dephase.load();
-				lcd.locate( 0, 2 );
-				lcd.printf( PH_PRINT PH_REF_PRINT, ph, 100 * ( ( float )ph / fq ) );
-			}
-			if ( flag & ( 1 << 3 ) ) {
-				//PRINT FQ
-				lcd.locate( 0, 3 );
-				lcd.printf( FQ_PRINT FQ_REF_PRINT, fq, 96000 / fq );
+			for ( uint32_t r = 0; r < 4; r++ ) {
+				//bit r set: row r changed
+				if ( flag & ( 1 << r ) ) {
+					printRow( r, waveConfig );
+				}
 			}
 			//Move cursor back to original position
 			lcd.moveCursor( rowpos[row.load()], row.load() );
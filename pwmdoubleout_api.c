@@ -17,6 +17,7 @@
 #include "pwmdoubleout_api.h"
 #include "cmsis.h"
 #include "pinmap.h"
+#include "cycle_probe.h"
 
 #define TCR_CNT_EN       0x00000001
 #define TCR_RESET        0x00000002
@@ -52,7 +53,197 @@ __IO uint32_t *PWMDOUBLE_MATCH[] = {
 
 #define TCR_PWM_EN       0x00000008
 
-static unsigned int pwm_clock_mhz;
+#define MCR_MR0_INT      0x00000001
+#define MCR_MR0_RESET    0x00000002
+
+#define PWMDOUBLE_IRQ_SLOTS 6
+
+#define DEMCR_TRCENA     0x01000000
+#define DWT_CTRL_CYCCNT  0x00000001
+
+// Timer tick rate: CCLK / PCLK divider / ( PR + 1 )
+static uint32_t pwm_clock_hz;
+// CCLK cycles per timer tick: PCLK divider * ( PR + 1 )
+static uint32_t pwm_cycles_per_tick;
+
+// Software copy of MR0..MR6. Every setter computes from this cache and
+// stores each match register it changes exactly once, so the hardware
+// shadow registers are never read back.
+uint32_t pwmdoubleout_match[7];
+// Pulse width in ticks, indexed by PWM channel
+uint32_t pwmdoubleout_width[7];
+// Rise, width and period as the channel was last set, indexed the same
+uint32_t pwmdoubleout_base_rise[7];
+uint32_t pwmdoubleout_base_width[7];
+uint32_t pwmdoubleout_base_period[7];
+
+// Double edge channels set up by pwmdoubleout_init, one bit per PWM channel
+static uint32_t pwm_channels;
+static int pwm_running;
+// MR0 as last stored, and as last known to be in force: while LER bit 0 is
+// set the stored value is still waiting for a period start
+static uint32_t pwm_mr0_stored;
+static uint32_t pwm_mr0_latched;
+
+// Dithered channels: rise and width in ticks with PWMDOUBLEOUT_DITHER_BITS
+// fractional bits, the error accumulated by each and the tick added to the
+// values last stored. Channels in pwm_dither_fresh have not been stepped yet.
+static struct {
+	uint32_t rise;
+	uint32_t width;
+	int32_t rise_error;
+	int32_t width_error;
+	uint32_t rise_carry;
+	uint32_t width_carry;
+} pwm_dither[7];
+static uint32_t pwm_dither_channels;
+static uint32_t pwm_dither_fresh;
+
+// Pulse bursts: the edges of the pulse and of the idle output, and the
+// periods left before the interrupt has to act on the channel
+enum {
+	BURST_START,   // idle until the first period of the burst is staged
+	BURST_RUN,     // pulsing, 'left' counts down to the last pulse
+	BURST_GAP      // idle between repeats
+};
+static struct {
+	uint32_t rise;
+	uint32_t fall;
+	uint32_t off;
+	uint32_t count;
+	uint32_t interval;
+	uint32_t left;
+	uint32_t state;
+	pwmdoubleout_irq_handler done;
+	uintptr_t id;
+} pwm_burst[7];
+static uint32_t pwm_burst_channels;
+
+// Period interrupt handlers, called in slot order on every MR0 match, and
+// the number of slots in use
+static struct {
+	pwmdoubleout_irq_handler handler;
+	uintptr_t id;
+} pwm_irq[PWMDOUBLE_IRQ_SLOTS];
+unsigned int pwmdoubleout_irq_used;
+
+// Cycle count of the MR0 match the last period interrupt was taken for, or
+// of the period start before the first handler was attached, the MR0 in
+// force from there, and the periods from the one before
+static uint32_t pwm_irq_match_cycles;
+static uint32_t pwm_irq_period;
+static uint32_t pwm_irq_elapsed;
+// Periods the interrupt missed, and times its handlers ran into the next one
+static uint32_t pwm_irq_overruns;
+
+// Open group transactions and the match registers they have staged
+unsigned int pwmdoubleout_group_depth;
+uint32_t pwmdoubleout_group_mask;
+
+// Store the cached match registers in mask and latch them at the next period
+// start, or stage them until the outermost group is committed. Main context.
+static void pwmdoubleout_store_match_regs( uint32_t mask );
+
+static void pwmdoubleout_latch( uint32_t mask ) {
+	if ( pwmdoubleout_group_depth > 0 ) {
+		pwmdoubleout_group_mask |= mask;
+		return;
+	}
+	pwmdoubleout_store_match_regs( mask );
+	pwmdoubleout_ler_set( mask );
+}
+
+// MR0 of the period under way
+static inline uint32_t pwmdoubleout_mr0_active( void ) {
+	return ( LPC_PWM1->LER & ( 1 << 0 ) ) ? pwm_mr0_latched : pwm_mr0_stored;
+}
+
+static void pwmdoubleout_store_match_regs( uint32_t mask ) {
+	for ( int i = 0; mask >> i; i++ ) {
+		if ( mask & ( 1 << i ) ) {
+			*PWMDOUBLE_MATCH[i] = pwmdoubleout_match[i];
+		}
+	}
+	if ( mask & ( 1 << 0 ) ) {
+		pwm_mr0_latched = pwmdoubleout_mr0_active();
+		pwm_mr0_stored = pwmdoubleout_match[0];
+	}
+}
+
+// Store and latch regardless of open groups, for the period interrupt
+static void pwmdoubleout_store( uint32_t mask ) {
+	pwmdoubleout_store_match_regs( mask );
+	LPC_PWM1->LER |= mask;
+}
+
+// Scale a fraction of the period in [0, 1] to ticks. Above 2^31 the float
+// product no longer converts to int, so it saturates instead.
+static inline int pwmdoubleout_float_ticks( float fraction ) {
+	float ticks = ( float )( pwmdoubleout_match[0] ) * fraction;
+	return ( ticks >= 2147483647.0f ) ? INT32_MAX : ( int )ticks;
+}
+
+// Microseconds to ticks at the current clock, saturated to the int setters
+static int pwmdoubleout_us_ticks( int us ) {
+	if ( us <= 0 ) {
+		return 0;
+	}
+	uint64_t ticks = ( ( uint64_t )pwm_clock_hz * ( uint32_t )us ) / 1000000;
+	return ( ticks > INT32_MAX ) ? INT32_MAX : ( int )ticks;
+}
+
+// Rescale a channel's edges to a new period, keeping duty cycle and dephase.
+// Scaled from the edges as last set, not from the rounded cache, so a run of
+// retunes (a period ramp up and back) comes back to the same ticks.
+static void pwmdoubleout_rescale( int pwm, uint32_t ticks ) {
+	uint32_t period = pwmdoubleout_base_period[pwm];
+	uint32_t rise = 0;
+	uint32_t width = 0;
+	if ( period > 0 ) {
+		rise  = ( uint32_t )( ( ( uint64_t )pwmdoubleout_base_rise[pwm] * ticks ) / period );
+		width = ( uint32_t )( ( ( uint64_t )pwmdoubleout_base_width[pwm] * ticks ) / period );
+	}
+	// a bare MR0 load can have left the rise beyond the period
+	rise = pwmdoubleout_wrap( rise, ticks );
+	pwmdoubleout_width[pwm] = width;
+	pwmdoubleout_match[pwm - 1] = rise;
+	pwmdoubleout_match[pwm] = pwmdoubleout_fall( rise, width, ticks );
+}
+
+// PCLKSEL0 field value for a CCLK divider of 1, 2, 4 or 8
+static uint32_t pwmdoubleout_pclksel( uint32_t div ) {
+	switch ( div ) {
+	case 1:
+		return 0x1;
+	case 2:
+		return 0x2;
+	case 8:
+		return 0x3;
+	default:
+		return 0x0;   // /4
+	}
+}
+
+// Latch mask at the next period start. The counter is only reset the first
+// time it is started; afterwards it keeps running so no period is truncated.
+static void pwmdoubleout_commit_period( uint32_t mask ) {
+	if ( pwm_running ) {
+		pwmdoubleout_latch( mask );
+		return;
+	}
+	// set reset
+	LPC_PWM1->TCR = TCR_RESET;
+
+	pwmdoubleout_latch( mask );
+	// the counter starts on it
+	pwm_mr0_latched = pwmdoubleout_match[0];
+	pwm_irq_match_cycles = DWT->CYCCNT;
+	pwm_irq_period = pwmdoubleout_match[0];
+
+	// enable counter and pwm, clear reset
+	LPC_PWM1->TCR = TCR_CNT_EN | TCR_PWM_EN;
+	pwm_running = 1;
+}
 
 void pwmdoubleout_init( pwmdoubleout_t* obj, PinName pin ) {
 	// determine the channel
@@ -66,23 +257,29 @@ void pwmdoubleout_init( pwmdoubleout_t* obj, PinName pin ) {
 	// ensure the power is on
 	LPC_SC->PCONP |= 1 << 6;
 
-	// ensure clock to /1
-	LPC_SC->PCLKSEL0 &= ~( 0x3 << 12 );   // mask
-	LPC_SC->PCLKSEL0 |= ( 0x1 << 12 ); //pclk = /1
-	LPC_PWM1->PR = 0;                     // no pre-scale
+	// ensure clock to /1, unless a plan was applied for an earlier channel
+	if ( !pwm_channels ) {
+		LPC_SC->PCLKSEL0 &= ~( 0x3 << 12 );   // mask
+		LPC_SC->PCLKSEL0 |= ( 0x1 << 12 ); //pclk = /1
+		LPC_PWM1->PR = 0;                     // no pre-scale
+		pwm_clock_hz = SystemCoreClock;
+		pwm_cycles_per_tick = 1;
+	}
 
 
-	LPC_PWM1->MCR = 1 << 1; // reset TC on match 0
+	LPC_PWM1->MCR |= MCR_MR0_RESET; // reset TC on match 0
 
 	// enable the specific PWM output
 	// set double edge mode
 	LPC_PWM1->PCR |=  1 << ( 8 + pwm ) | ( 1 << ( pwm ) ) ;
 
-	pwm_clock_mhz = SystemCoreClock / 1000000;
-
 	//Initialize MRA to 0
-	*obj->MRA = 0;
-	*obj->MRB = 0;
+	pwmdoubleout_match[pwm - 1] = 0;
+	pwmdoubleout_match[pwm] = 0;
+	pwmdoubleout_width[pwm] = 0;
+	pwmdoubleout_cache_base( pwm );
+	pwm_channels |= 1 << pwm;
+	pwmdoubleout_latch( ( 1 << pwm ) | ( 1 << ( pwm - 1 ) ) );
 
 	// default to 20ms: standard for servos, and fine for e.g. brightness control
 	pwmdoubleout_period_ms( obj, 20 );
@@ -97,130 +294,542 @@ void pwmdoubleout_free( pwmdoubleout_t* obj ) {
 	// [TODO]
 }
 
-void pwmdoubleout_dephase      ( pwmdoubleout_t* obj, float percent ) {
-	if ( percent < 0.0f ) {
-		percent = 0.0;
-	} else if ( percent > 1.0f ) {
-		percent = 1.0;
+unsigned int pwmdoubleout_clock_mhz( void ) {
+	return pwm_clock_hz / 1000000;
+}
+
+uint32_t pwmdoubleout_clock_hz( void ) {
+	return pwm_clock_hz;
+}
+
+// Pick the PCLK divider, PR and MR0 closest to freq_hz with at least
+// min_steps ticks per period; on equal error the finer resolution wins.
+// Returns -1 if no setting reaches min_steps.
+int pwmdoubleout_plan( pwmdoubleout_plan_t* plan, uint32_t freq_hz, uint32_t min_steps ) {
+	static const uint32_t dividers[] = { 1, 2, 4, 8 };
+	uint64_t cclk = SystemCoreClock;
+	uint64_t best_error = UINT64_MAX;
+	int found = -1;
+
+	if ( freq_hz == 0 ) {
+		return -1;
+	}
+	if ( min_steps == 0 ) {
+		min_steps = 1;
+	}
+	for ( int i = 0; i < 4; i++ ) {
+		for ( uint32_t prescale = 1; prescale <= PWMDOUBLEOUT_PLAN_MAX_PRESCALE; prescale++ ) {
+			uint64_t cycles = ( uint64_t )dividers[i] * prescale * freq_hz;
+			if ( cycles * min_steps > cclk + cycles / 2 ) {
+				break;   // coarser from here on
+			}
+			uint64_t period = ( cclk + cycles / 2 ) / cycles;
+			if ( period < min_steps || period > INT32_MAX ) {
+				continue;
+			}
+			// |achieved - requested| / requested, scaled by 1e9
+			uint64_t actual = cycles * period;
+			uint64_t diff = ( cclk > actual ) ? cclk - actual : actual - cclk;
+			uint64_t error = diff * 1000000000ull / actual;
+			if ( error < best_error || ( error == best_error && period > plan->period ) ) {
+				best_error = error;
+				plan->pclk_div = dividers[i];
+				plan->prescale = prescale;
+				plan->period = ( uint32_t )period;
+				found = 0;
+			}
+		}
+	}
+	if ( found == 0 ) {
+		uint64_t ticks = ( uint64_t )plan->pclk_div * plan->prescale * plan->period;
+		plan->freq_hz = ( uint32_t )( ( cclk + ticks / 2 ) / ticks );
+		// signed throughout: with ticks unsigned, a frequency below the
+		// request wrapped
+		plan->error_ppm = ( int32_t )( ( ( int64_t )cclk * 1000000 / ( int64_t )ticks -
+		                                 ( int64_t )freq_hz * 1000000 ) / ( int64_t )freq_hz );
 	}
-	//for debuggig purposes
-	// *obj->MRA = 0;
-	uint32_t mra = *obj->MRA;
-	uint32_t mrb = *obj->MRB;
-	uint32_t mr0 = LPC_PWM1->MR0;
+	return found;
+}
 
-	// set channel match to percentage
-	uint32_t v = ( uint32_t )( ( float )( LPC_PWM1->MR0 ) * percent );
+// Switch the timer clock and period together, keeping every channel's
+// duty cycle and dephase. The counter is restarted so no period runs with
+// a mix of old and new settings; not to be called inside a group.
+void pwmdoubleout_apply_plan( const pwmdoubleout_plan_t* plan ) {
+	uint32_t mask = 1 << 0;
+	MBED_ASSERT( pwmdoubleout_group_depth == 0 );
+
+	for ( int pwm = PWM_2; pwm <= PWM_6; pwm++ ) {
+		if ( pwm_channels & ( 1 << pwm ) ) {
+			pwmdoubleout_rescale( pwm, plan->period );
+			mask |= ( 1 << pwm ) | ( 1 << ( pwm - 1 ) );
+		}
+	}
+	pwmdoubleout_match[0] = plan->period;
+
+	// hold the counter while the clock changes
+	LPC_PWM1->TCR = TCR_RESET;
+	LPC_SC->PCLKSEL0 = ( LPC_SC->PCLKSEL0 & ~( 0x3 << 12 ) ) |
+	                   ( pwmdoubleout_pclksel( plan->pclk_div ) << 12 );
+	LPC_PWM1->PR = plan->prescale - 1;
+	pwm_clock_hz = SystemCoreClock / ( plan->pclk_div * plan->prescale );
+	pwm_cycles_per_tick = plan->pclk_div * plan->prescale;
+
+	pwm_running = 0;
+	pwmdoubleout_commit_period( mask );
+}
+
+void pwmdoubleout_group_begin( void ) {
+	pwmdoubleout_group_depth++;
+}
 
-	// workaround for PWM1[1] - Never make it equal MR0, else we get 1 cycle dropout
-	if ( v == LPC_PWM1->MR0 ) {
-		v++;
+void pwmdoubleout_group_commit( void ) {
+	MBED_ASSERT( pwmdoubleout_group_depth > 0 );
+	if ( --pwmdoubleout_group_depth > 0 ) {
+		return;
 	}
-	// get duty cycle to preserve it
-	float dutyCycle = pwmdoubleout_read( obj );
+	uint32_t mask = pwmdoubleout_group_mask;
+	pwmdoubleout_group_mask = 0;
+	// one store per staged match register, one LER write for all channels
+	pwmdoubleout_latch( mask );
+}
 
-	*obj->MRA = v;
+// Copy raw match values into the cache and derive the pulse widths of the
+// channels involved
+static void pwmdoubleout_cache_match( const uint32_t* match, uint32_t mask ) {
+	for ( int i = 0; mask >> i; i++ ) {
+		if ( mask & ( 1 << i ) ) {
+			pwmdoubleout_match[i] = match[i];
+		}
+	}
+	uint32_t period = pwmdoubleout_match[0];
+	for ( int pwm = PWM_2; pwm <= PWM_6; pwm++ ) {
+		if ( ( pwm_channels & ( 1 << pwm ) ) &&
+		     ( mask & ( ( 1 << pwm ) | ( 1 << ( pwm - 1 ) ) | ( 1 << 0 ) ) ) ) {
+			uint32_t rise = pwmdoubleout_match[pwm - 1];
+			uint32_t fall = pwmdoubleout_match[pwm];
+			if ( fall > period ) {
+				pwmdoubleout_width[pwm] = period;
+			} else if ( fall >= rise ) {
+				pwmdoubleout_width[pwm] = fall - rise;
+			} else {
+				//wraparound
+				pwmdoubleout_width[pwm] = fall + period - rise;
+			}
+			pwmdoubleout_cache_base( pwm );
+		}
+	}
+}
 
-	*obj->MRB = v + ( ( uint32_t )( dutyCycle * ( float )( LPC_PWM1->MR0 ) ) );
-	//wraparound
-	if ( *obj->MRB >= LPC_PWM1->MR0 ) {
-		*obj->MRB = *obj->MRB - LPC_PWM1->MR0;
+// Load raw match values: the cache, the pulse widths of the channels
+// involved and the hardware are updated together. Staged by open groups.
+void pwmdoubleout_load_match( const uint32_t* match, uint32_t mask ) {
+	pwmdoubleout_cache_match( match, mask );
+	pwmdoubleout_latch( mask );
+}
+
+// As pwmdoubleout_load_match, for the period interrupt: stored at once so
+// that a group held open by the interrupted code cannot delay the values
+void pwmdoubleout_store_match( const uint32_t* match, uint32_t mask ) {
+	pwmdoubleout_cache_match( match, mask );
+	pwmdoubleout_store( mask );
+}
+
+// The slot table, MR0INT and the NVIC enable are only changed with the
+// interrupt masked: handlers detach themselves from the interrupt, which
+// must not interleave with an attach from thread context.
+int pwmdoubleout_irq_attach( pwmdoubleout_irq_handler handler, uintptr_t id ) {
+	int used = 0;
+	int slot = -1;
+	NVIC_DisableIRQ( PWM1_IRQn );
+	for ( int i = 0; i < PWMDOUBLE_IRQ_SLOTS; i++ ) {
+		if ( pwm_irq[i].handler ) {
+			used++;
+		} else if ( slot < 0 ) {
+			slot = i;
+		}
 	}
-	if ( *obj->MRA >= LPC_PWM1->MR0 ) {
-		*obj->MRA = *obj->MRA - LPC_PWM1->MR0;
+	if ( slot >= 0 ) {
+		pwm_irq[slot].id = id;
+		pwm_irq[slot].handler = handler;
+		if ( used == 0 ) {
+			// interrupt on match 0, i.e. at every period start, each one
+			// timed by the cycle counter from the period under way, so
+			// that even the first one is seen when late
+			uint32_t tc = LPC_PWM1->TC;
+			CoreDebug->DEMCR |= DEMCR_TRCENA;
+			DWT->CTRL |= DWT_CTRL_CYCCNT;
+			pwm_irq_match_cycles = DWT->CYCCNT - tc * pwm_cycles_per_tick;
+			pwm_irq_period = pwmdoubleout_mr0_active();
+			// ahead of anything that can hold it past a period start
+			NVIC_SetPriority( PWM1_IRQn, PWMDOUBLEOUT_IRQ_PRIORITY );
+			LPC_PWM1->MCR |= MCR_MR0_INT;
+		}
+		used++;
 	}
-	//debugging purposes
-	mra = *obj->MRA;
-	mrb = *obj->MRB;
-	// accept on next period start
-	LPC_PWM1->LER |= ( 1 << obj->pwm ) | ( 1 << ( obj->pwm - 1 ) );
+	pwmdoubleout_irq_used = used;
+	if ( used > 0 ) {
+		NVIC_EnableIRQ( PWM1_IRQn );
+	}
+	return ( slot >= 0 ) ? 0 : -1;
 }
-void pwmdoubleout_set_dephase      ( pwmdoubleout_t* obj, int reg_value ) {
 
-	// workaround for PWM1[1] - Never make it equal MR0, else we get 1 cycle dropout
-	// if ( reg_value == LPC_PWM1->MR0 ) {
-	// 	reg_value++;
-	// }
-	//Finding out the pulse width
-	int oldMRB = *obj->MRB;
-	int diff = reg_value - *obj->MRA;
-	*obj->MRA = reg_value;
-	int newMRB = *obj->MRB + diff;
-
-	//wraparound
-	*obj->MRB = newMRB;
-	if ( newMRB < 0 ) {
-		newMRB += LPC_PWM1->MR0;
-	}
-	if ( oldMRB < LPC_PWM1->MR0 && diff != LPC_PWM1->MR0 ) {
-		if ( newMRB >= LPC_PWM1->MR0 ) {
-			newMRB -= LPC_PWM1->MR0;
+void pwmdoubleout_irq_detach( pwmdoubleout_irq_handler handler, uintptr_t id ) {
+	int used = 0;
+	NVIC_DisableIRQ( PWM1_IRQn );
+	for ( int i = 0; i < PWMDOUBLE_IRQ_SLOTS; i++ ) {
+		if ( pwm_irq[i].handler == handler && pwm_irq[i].id == id ) {
+			pwm_irq[i].handler = 0;
 		}
-		*obj->MRB = newMRB;
-		if ( *obj->MRA >= LPC_PWM1->MR0 ) {
-			*obj->MRA = *obj->MRA - LPC_PWM1->MR0;
+		if ( pwm_irq[i].handler ) {
+			used++;
 		}
 	}
-	//debugging purposes
-	uint32_t mra = *obj->MRA;
-	uint32_t mrb = *obj->MRB;
-	// accept on next period start
-	LPC_PWM1->LER |= ( 1 << obj->pwm ) | ( 1 << ( obj->pwm - 1 ) );
+	pwmdoubleout_irq_used = used;
+	if ( used > 0 ) {
+		NVIC_EnableIRQ( PWM1_IRQn );
+	} else {
+		LPC_PWM1->MCR &= ~MCR_MR0_INT;
+	}
 }
 
-void pwmdoubleout_write( pwmdoubleout_t* obj, float value ) {
-	if ( value < 0.0f ) {
-		value = 0.0;
-	} else if ( value > 1.0f ) {
-		value = 1.0;
+// Periods since the previous interrupt. The MR0 match this one is for lies
+// TC ticks back from the cycle counter. The first period from the previous
+// match ran with the MR0 in force then; whatever distance is left, rounded
+// to whole periods of the MR0 in force now, is matches coalesced into this
+// interrupt by it being late. A retune stored in between only took effect
+// at one of those matches, so neither period is the one cached for the
+// next, pwmdoubleout_match[0].
+static uint32_t pwmdoubleout_irq_count( uint32_t tc ) {
+	uint32_t match = DWT->CYCCNT - tc * pwm_cycles_per_tick;
+	uint32_t active = pwmdoubleout_mr0_active();
+	uint32_t first = pwm_irq_period * pwm_cycles_per_tick;
+	uint32_t period = active * pwm_cycles_per_tick;
+	uint32_t since = match - pwm_irq_match_cycles;
+	uint32_t elapsed = 1;
+	if ( period > 0 && since + period / 2 > first ) {
+		elapsed += ( since + period / 2 - first ) / period;
 	}
+	pwm_irq_match_cycles = match;
+	pwm_irq_period = active;
+	return elapsed;
+}
 
-	// set channel match to percentage
-	uint32_t v = ( uint32_t )( ( float )( LPC_PWM1->MR0 ) * value );
+// Periods since the previous period interrupt, for the handlers
+uint32_t pwmdoubleout_irq_elapsed( void ) {
+	return pwm_irq_elapsed;
+}
 
-	// workaround for PWM1[1] - Never make it equal MR0, else we get 1 cycle dropout
-	if ( v == LPC_PWM1->MR0 ) {
-		v++;
+// Periods whose interrupt was coalesced into a later one, plus interrupts
+// whose handlers were still running when the next period started. Either
+// way values meant for one period were late for it.
+uint32_t pwmdoubleout_irq_overruns( void ) {
+	return pwm_irq_overruns;
+}
+
+// Installed through the CMSIS vector table name rather than NVIC_SetVector
+void PWM1_IRQHandler( void ) {
+	uint32_t tc;
+	CYCLE_PROBE_BEGIN( CYCLE_PROBE_PWM_IRQ );
+	// time the match before clearing its flag: one that comes in between
+	// raises no interrupt of its own, but is counted by the next one
+	tc = LPC_PWM1->TC;
+	pwm_irq_elapsed = pwmdoubleout_irq_count( tc );
+	LPC_PWM1->IR = 1 << 0;
+	pwm_irq_overruns += pwm_irq_elapsed - 1;
+	for ( int i = 0; i < PWMDOUBLE_IRQ_SLOTS; i++ ) {
+		if ( pwm_irq[i].handler ) {
+			pwm_irq[i].handler( pwm_irq[i].id );
+		}
 	}
-	uint32_t mrb = *obj->MRA + v;
-	*obj->MRB = mrb;
-	// *obj->MRB = *obj->MRA + v;
-	//wraparound
-	if ( *obj->MRB >= LPC_PWM1->MR0 ) {
-		*obj->MRB = *obj->MRB - LPC_PWM1->MR0;
+	// the timer wrapped while the handlers ran: what they stored for the
+	// period that started may only latch at the one after
+	if ( LPC_PWM1->TC < tc ) {
+		pwm_irq_overruns++;
 	}
+	CYCLE_PROBE_END( CYCLE_PROBE_PWM_IRQ );
+}
 
-	// accept on next period start
-	LPC_PWM1->LER |= 1 << obj->pwm;
+// One sigma-delta step of a dithered edge: the fractional part is added to
+// the error, and a carry adds one tick to the next period. The 'missed'
+// periods that passed without an interrupt repeated the last carry, so
+// they are accounted for first; the debt is limited to one tick either way.
+static uint32_t pwmdoubleout_dither_step( uint32_t value, int32_t* error,
+        uint32_t* carry, uint32_t missed ) {
+	const int32_t one = 1 << PWMDOUBLEOUT_DITHER_BITS;
+	int32_t fraction = ( int32_t )( value & ( one - 1 ) );
+	if ( missed ) {
+		int64_t debt = ( int64_t )missed * ( fraction - ( int32_t )*carry * one );
+		int64_t total = *error + debt;
+		*error = ( int32_t )( ( total < -one ) ? -one : ( total > 2 * one - 1 ) ? 2 * one - 1 : total );
+	}
+	*error += fraction;
+	*carry = 0;
+	if ( *error >= one ) {
+		*error -= one;
+		*carry = 1;
+	}
+	return *carry;
 }
-void pwmdoubleout_set_duty_cycle( pwmdoubleout_t* obj, int reg_value ) {
 
-	uint32_t mrb = *obj->MRA + reg_value;
-	if ( reg_value != LPC_PWM1->MR0 ) {
-		if ( mrb >= LPC_PWM1->MR0 ) {
-			//wraparound
-			mrb = mrb - LPC_PWM1->MR0;
+// First order sigma-delta on the rise and width of each dithered channel.
+// Runs at the period start, so the values apply to the next period.
+static void pwmdoubleout_dither_irq( uintptr_t id ) {
+	uint32_t period = pwmdoubleout_match[0];
+	uint32_t missed = pwmdoubleout_irq_elapsed() - 1;
+	uint32_t mask = 0;
+	( void )id;
+
+	for ( int pwm = PWM_2; pwm <= PWM_6; pwm++ ) {
+		if ( !( pwm_dither_channels & ( 1 << pwm ) ) ) {
+			continue;
 		}
-		//workaround
-		if ( *obj->MRA != 0 && mrb == 0 ) {
-			mrb = 1;
+		// a channel just started has no carry of its own to make up for
+		uint32_t late = ( pwm_dither_fresh & ( 1 << pwm ) ) ? 0 : missed;
+		uint32_t rise = ( pwm_dither[pwm].rise >> PWMDOUBLEOUT_DITHER_BITS ) +
+		                pwmdoubleout_dither_step( pwm_dither[pwm].rise, &pwm_dither[pwm].rise_error,
+		                                          &pwm_dither[pwm].rise_carry, late );
+		uint32_t width = ( pwm_dither[pwm].width >> PWMDOUBLEOUT_DITHER_BITS ) +
+		                 pwmdoubleout_dither_step( pwm_dither[pwm].width, &pwm_dither[pwm].width_error,
+		                                           &pwm_dither[pwm].width_carry, late );
+		rise = pwmdoubleout_wrap( rise, period );
+		pwmdoubleout_width[pwm] = width;
+		pwmdoubleout_match[pwm - 1] = rise;
+		pwmdoubleout_match[pwm] = pwmdoubleout_fall( rise, width, period );
+		mask |= ( 1 << pwm ) | ( 1 << ( pwm - 1 ) );
+	}
+	pwm_dither_fresh = 0;
+	// not staged by an open group: each value is meant for one period
+	pwmdoubleout_store( mask );
+}
+
+// Set rise and width in ticks with PWMDOUBLEOUT_DITHER_BITS fractional bits.
+// The channel is then rewritten by the period interrupt every period, so
+// the other setters must not be used on it until pwmdoubleout_dither_stop.
+// The interrupt has to be taken within the period it is raised in: any
+// handler that can run for longer than that must have a lower priority
+// than PWMDOUBLEOUT_IRQ_PRIORITY.
+// Periods it still misses repeat the last values and are made up for in
+// the following ones, up to one tick.
+void pwmdoubleout_dither( pwmdoubleout_t* obj, uint32_t rise, uint32_t width ) {
+	int pwm = obj->pwm;
+	if ( !pwm_dither_channels ) {
+		if ( pwmdoubleout_irq_attach( &pwmdoubleout_dither_irq, 0 ) < 0 ) {
+			// no interrupt slot: fall back to the nearest tick
+			pwmdoubleout_set_edges( obj, rise >> PWMDOUBLEOUT_DITHER_BITS,
+			                        width >> PWMDOUBLEOUT_DITHER_BITS );
+			return;
 		}
-	} else {
-		mrb++;
 	}
-	*obj->MRB = mrb;
+	// the interrupt must not see a half updated channel
+	NVIC_DisableIRQ( PWM1_IRQn );
+	if ( !( pwm_dither_channels & ( 1 << pwm ) ) ) {
+		pwm_dither[pwm].rise_error = 0;
+		pwm_dither[pwm].width_error = 0;
+		pwm_dither[pwm].rise_carry = 0;
+		pwm_dither[pwm].width_carry = 0;
+		pwm_dither_fresh |= 1 << pwm;
+	}
+	pwm_dither[pwm].rise = rise;
+	pwm_dither[pwm].width = width;
+	pwm_dither_channels |= 1 << pwm;
+	NVIC_EnableIRQ( PWM1_IRQn );
+}
+
+// Leave dithering, rounding the channel to the nearest tick
+void pwmdoubleout_dither_stop( pwmdoubleout_t* obj ) {
+	int pwm = obj->pwm;
+	const uint32_t half = 1 << ( PWMDOUBLEOUT_DITHER_BITS - 1 );
+	if ( !( pwm_dither_channels & ( 1 << pwm ) ) ) {
+		return;
+	}
+	NVIC_DisableIRQ( PWM1_IRQn );
+	pwm_dither_channels &= ~( 1 << pwm );
+	NVIC_EnableIRQ( PWM1_IRQn );
+	if ( !pwm_dither_channels ) {
+		pwmdoubleout_irq_detach( &pwmdoubleout_dither_irq, 0 );
+	}
+	pwmdoubleout_set_edges( obj, ( pwm_dither[pwm].rise + half ) >> PWMDOUBLEOUT_DITHER_BITS,
+	                        ( pwm_dither[pwm].width + half ) >> PWMDOUBLEOUT_DITHER_BITS );
+}
+
+// Store the edges of one channel straight to the match registers, leaving
+// pwmdoubleout_match holding the continuous setting
+static inline void pwmdoubleout_burst_edges( int pwm, uint32_t rise, uint32_t fall ) {
+	*PWMDOUBLE_MATCH[pwm - 1] = rise;
+	*PWMDOUBLE_MATCH[pwm] = fall;
+	LPC_PWM1->LER |= ( 1 << pwm ) | ( 1 << ( pwm - 1 ) );
+}
+
+// Runs at every period start and stages the edges for the next period, so
+// the period in which a channel's 'left' reaches zero is always the last
+// one of its current state. Most calls only decrement the counters.
+static void pwmdoubleout_burst_irq( uintptr_t id ) {
+	// count periods, not interrupts: matches coalesced into a late
+	// interrupt still pulsed. One late past the last pulse leaves an extra
+	// pulse per missed period, which pwmdoubleout_irq_overruns() shows.
+	uint32_t elapsed = pwmdoubleout_irq_elapsed();
+	( void )id;
+
+	for ( int pwm = PWM_2; pwm <= PWM_6; pwm++ ) {
+		if ( !( pwm_burst_channels & ( 1 << pwm ) ) ) {
+			continue;
+		}
+		if ( pwm_burst[pwm].left > elapsed ) {
+			pwm_burst[pwm].left -= elapsed;
+			continue;
+		}
+		if ( pwm_burst[pwm].state != BURST_RUN ) {
+			// the next period carries the first pulse
+			pwmdoubleout_burst_edges( pwm, pwm_burst[pwm].rise, pwm_burst[pwm].fall );
+			pwm_burst[pwm].left = pwm_burst[pwm].count;
+			pwm_burst[pwm].state = BURST_RUN;
+			continue;
+		}
+		// this period carries the last pulse: idle from the next one
+		pwmdoubleout_burst_edges( pwm, pwm_burst[pwm].off, pwm_burst[pwm].off );
+		if ( pwm_burst[pwm].interval ) {
+			pwm_burst[pwm].left = pwm_burst[pwm].interval;
+			pwm_burst[pwm].state = BURST_GAP;
+		} else {
+			pwm_burst_channels &= ~( 1 << pwm );
+			if ( !pwm_burst_channels ) {
+				pwmdoubleout_irq_detach( &pwmdoubleout_burst_irq, 0 );
+			}
+		}
+		if ( pwm_burst[pwm].done ) {
+			pwm_burst[pwm].done( pwm_burst[pwm].id );
+		}
+	}
+}
+
+// Emit 'count' pulses with the channel's current rise and width, then keep
+// the output low. With a non zero interval the burst repeats after that many
+// idle periods until pwmdoubleout_burst_stop. 'done' is called from the
+// period interrupt once the last pulse of each burst is under way.
+// The pulses start at the second period start from now; the output is low
+// until then. Open groups do not stage the burst edges, and the other
+// setters must not be used on the channel until the burst has ended.
+int pwmdoubleout_burst( pwmdoubleout_t* obj, uint32_t count, uint32_t interval,
+                        pwmdoubleout_irq_handler done, uintptr_t id ) {
+	int pwm = obj->pwm;
+	uint32_t period = pwmdoubleout_match[0];
+	uint32_t fall = pwmdoubleout_match[pwm];
+	if ( count == 0 ) {
+		return -1;
+	}
+	// the interrupt must not see a half updated channel, nor detach the
+	// handler between the test and the update below
+	NVIC_DisableIRQ( PWM1_IRQn );
+	if ( !pwm_burst_channels ) {
+		if ( pwmdoubleout_irq_attach( &pwmdoubleout_burst_irq, 0 ) < 0 ) {
+			// all slots taken, so the interrupt was enabled
+			NVIC_EnableIRQ( PWM1_IRQn );
+			return -1;
+		}
+		NVIC_DisableIRQ( PWM1_IRQn );
+	}
+	pwm_burst[pwm].rise = pwmdoubleout_match[pwm - 1];
+	pwm_burst[pwm].fall = fall;
+	// rise and fall on the same tick never set the output; at the pulse's
+	// own fall tick, a pulse wrapping into the idle period keeps its width
+	pwm_burst[pwm].off = ( fall < period ) ? fall : 0;
+	pwm_burst[pwm].count = count;
+	pwm_burst[pwm].interval = interval;
+	pwm_burst[pwm].done = done;
+	pwm_burst[pwm].id = id;
+	pwm_burst[pwm].left = 1;
+	pwm_burst[pwm].state = BURST_START;
+	pwmdoubleout_burst_edges( pwm, pwm_burst[pwm].off, pwm_burst[pwm].off );
+	pwm_burst_channels |= 1 << pwm;
+	NVIC_EnableIRQ( PWM1_IRQn );
+	return 0;
+}
+
+// Abort a burst; the output is low from the next period start
+void pwmdoubleout_burst_stop( pwmdoubleout_t* obj ) {
+	int pwm = obj->pwm;
+	if ( !( pwm_burst_channels & ( 1 << pwm ) ) ) {
+		return;
+	}
+	NVIC_DisableIRQ( PWM1_IRQn );
+	pwm_burst_channels &= ~( 1 << pwm );
+	pwmdoubleout_burst_edges( pwm, pwm_burst[pwm].off, pwm_burst[pwm].off );
+	NVIC_EnableIRQ( PWM1_IRQn );
+	if ( !pwm_burst_channels ) {
+		pwmdoubleout_irq_detach( &pwmdoubleout_burst_irq, 0 );
+	}
+}
+
+int pwmdoubleout_burst_active( pwmdoubleout_t* obj ) {
+	return ( pwm_burst_channels >> obj->pwm ) & 1;
+}
+
+void pwmdoubleout_dephase      ( pwmdoubleout_t* obj, float percent ) {
+	if ( percent < 0.0f ) {
+		percent = 0.0;
+	} else if ( percent > 1.0f ) {
+		percent = 1.0;
+	}
+	// set channel match to percentage, the pulse width is kept in ticks
+	pwmdoubleout_set_dephase( obj, pwmdoubleout_float_ticks( percent ) );
+}
+void pwmdoubleout_dephase_q16  ( pwmdoubleout_t* obj, uint32_t fraction ) {
+	pwmdoubleout_set_dephase( obj, pwmdoubleout_q16_ticks( fraction ) );
+}
+void pwmdoubleout_set_dephase      ( pwmdoubleout_t* obj, int reg_value ) {
+	// keep the pulse width
+	pwmdoubleout_set_edges( obj, reg_value, pwmdoubleout_width[obj->pwm] );
+}
+// As pwmdoubleout_set_dephase, for the period interrupt: stored at once
+// whatever groups the interrupted code holds open, and not probed
+void pwmdoubleout_store_dephase( pwmdoubleout_t* obj, int reg_value ) {
+	pwmdoubleout_store( pwmdoubleout_cache_edges( obj->pwm, reg_value, pwmdoubleout_width[obj->pwm] ) );
+	pwmdoubleout_check( obj->pwm );
+}
+// Place both edges in one pass: rise at reg_rise, fall width ticks later
+void pwmdoubleout_set_edges ( pwmdoubleout_t* obj, int reg_rise, int width ) {
+	CYCLE_PROBE_BEGIN( CYCLE_PROBE_PWM_EDGES );
+	// accept on next period start
+	pwmdoubleout_latch( pwmdoubleout_cache_edges( obj->pwm, reg_rise, width ) );
+	pwmdoubleout_check( obj->pwm );
+	CYCLE_PROBE_END( CYCLE_PROBE_PWM_EDGES );
+}
+
+void pwmdoubleout_write( pwmdoubleout_t* obj, float value ) {
+	if ( value < 0.0f ) {
+		value = 0.0;
+	} else if ( value > 1.0f ) {
+		value = 1.0;
+	}
+	// set channel match to percentage
+	pwmdoubleout_set_duty_cycle( obj, pwmdoubleout_float_ticks( value ) );
+}
+void pwmdoubleout_write_q16( pwmdoubleout_t* obj, uint32_t fraction ) {
+	pwmdoubleout_set_duty_cycle( obj, pwmdoubleout_q16_ticks( fraction ) );
+}
+void pwmdoubleout_set_duty_cycle( pwmdoubleout_t* obj, int reg_value ) {
+	CYCLE_PROBE_BEGIN( CYCLE_PROBE_PWM_DUTY );
 	// accept on next period start
-	LPC_PWM1->LER |= 1 << obj->pwm;
+	pwmdoubleout_latch( pwmdoubleout_cache_duty( obj->pwm, reg_value ) );
+	pwmdoubleout_check( obj->pwm );
+	CYCLE_PROBE_END( CYCLE_PROBE_PWM_DUTY );
+}
+// As pwmdoubleout_set_duty_cycle, for the period interrupt: stored at once
+// whatever groups the interrupted code holds open, and not probed
+void pwmdoubleout_store_duty_cycle( pwmdoubleout_t* obj, int reg_value ) {
+	pwmdoubleout_store( pwmdoubleout_cache_duty( obj->pwm, reg_value ) );
+	pwmdoubleout_check( obj->pwm );
 }
 
 float pwmdoubleout_read( pwmdoubleout_t* obj ) {
-	float v = ( float )( ( int )( *obj->MRB ) - ( int )( *obj->MRA ) ) / ( float )(
-	              LPC_PWM1->MR0 );
-	//workaround for MRB < MRA
-	if ( v < 0 ) {
-		v = v + 1.0f;
+	uint32_t width = pwmdoubleout_width[obj->pwm];
+	if ( width >= pwmdoubleout_match[0] ) {
+		return 1.0f;
 	}
-	return ( v > 1.0f ) ? ( 1.0f ) : ( v );
+	return ( float )width / ( float )pwmdoubleout_match[0];
+}
+uint32_t pwmdoubleout_read_q16( pwmdoubleout_t* obj ) {
+	return pwmdoubleout_width_q16( obj->pwm );
 }
 
 void pwmdoubleout_period( pwmdoubleout_t* obj, float seconds ) {
@@ -232,65 +841,71 @@ void pwmdoubleout_period_ms( pwmdoubleout_t* obj, int ms ) {
 }
 
 void pwmdoubleout_freq_khz ( pwmdoubleout_t* obj, int khz ) {
-	uint32_t ticks = ( pwm_clock_mhz * 1000 ) / ( uint32_t )khz;
-
-	// set reset
-	LPC_PWM1->TCR = TCR_RESET;
+	pwmdoubleout_retune( obj, pwm_clock_hz / ( ( uint32_t )khz * 1000 ) );
+}
+// The period is shared by every channel: obj is not used and may be NULL
+void pwmdoubleout_set_freq ( pwmdoubleout_t* obj, int reg_value ) {
+	CYCLE_PROBE_BEGIN( CYCLE_PROBE_PWM_PERIOD );
+	uint32_t period = ( reg_value < 0 ) ? 0 : ( uint32_t )reg_value;
+	uint32_t mask = 1 << 0;
 
 	// set the global match register
-	LPC_PWM1->MR0 = ticks;
-
-	// Scale the pulse width to preserve the duty ratio
-	if ( LPC_PWM1->MR0 > 0 ) {
-		*obj->MRA = ( *obj->MRA * ticks ) / LPC_PWM1->MR0;
-		*obj->MRB = ( *obj->MRB * ticks ) / LPC_PWM1->MR0;
+	pwmdoubleout_match[0] = period;
+
+	// channels keep their rise and width in ticks; re-derive the fall edge
+	// (and fold the rise edge) against the new period
+	for ( int pwm = PWM_2; pwm <= PWM_6; pwm++ ) {
+		if ( pwm_channels & ( 1 << pwm ) ) {
+			uint32_t rise = pwmdoubleout_wrap( pwmdoubleout_match[pwm - 1], period );
+			pwmdoubleout_match[pwm - 1] = rise;
+			pwmdoubleout_match[pwm] = pwmdoubleout_fall( rise, pwmdoubleout_width[pwm], period );
+			pwmdoubleout_cache_base( pwm );
+			mask |= ( 1 << pwm ) | ( 1 << ( pwm - 1 ) );
+		}
 	}
 
-	// set the channel latch to update value at next period start
-	// LPC_PWM1->LER |= ( 1 << 0 ) | ( 1 << ( obj->pwm - 1 ) ) | ( 1 << obj->pwm );
-	LPC_PWM1->LER |=  1 << 0  ;
-
-	// enable counter and pwm, clear reset
-	LPC_PWM1->TCR = TCR_CNT_EN | TCR_PWM_EN;
+	// MR0 and all channels take the new values on the same period start
+	pwmdoubleout_commit_period( mask );
+	CYCLE_PROBE_END( CYCLE_PROBE_PWM_PERIOD );
 }
-void pwmdoubleout_set_freq ( pwmdoubleout_t* obj, int reg_value ) {
-	// set reset
-	LPC_PWM1->TCR = TCR_RESET;
 
-	// set the global match register
-	LPC_PWM1->MR0 = reg_value;
+// New period with every channel rescaled to it; returns the mask to store
+static uint32_t pwmdoubleout_cache_retune( int reg_value ) {
+	uint32_t ticks = ( reg_value < 0 ) ? 0 : ( uint32_t )reg_value;
+	uint32_t mask = 1 << 0;
 
-	// set the channel latch to update value at next period start
-	// LPC_PWM1->LER |= ( 1 << 0 ) | ( 1 << ( obj->pwm - 1 ) ) | ( 1 << obj->pwm );
-	LPC_PWM1->LER |=  1 << 0  ;
+	// Scale the pulse widths to preserve the duty ratios
+	for ( int pwm = PWM_2; pwm <= PWM_6; pwm++ ) {
+		if ( pwm_channels & ( 1 << pwm ) ) {
+			pwmdoubleout_rescale( pwm, ticks );
+			mask |= ( 1 << pwm ) | ( 1 << ( pwm - 1 ) );
+		}
+	}
 
-	// enable counter and pwm, clear reset
-	LPC_PWM1->TCR = TCR_CNT_EN | TCR_PWM_EN;
+	// set the global match register
+	pwmdoubleout_match[0] = ticks;
+	return mask;
+}
+
+// Change the period without resetting the counter, rescaling every channel.
+// obj is not used and may be NULL.
+void pwmdoubleout_retune( pwmdoubleout_t* obj, int reg_value ) {
+	CYCLE_PROBE_BEGIN( CYCLE_PROBE_PWM_PERIOD );
+	// MR0 and all channels take the new values on the same period start
+	pwmdoubleout_commit_period( pwmdoubleout_cache_retune( reg_value ) );
+	CYCLE_PROBE_END( CYCLE_PROBE_PWM_PERIOD );
+}
+// As pwmdoubleout_retune, for the period interrupt: stored at once whatever
+// groups the interrupted code holds open, and not probed. The counter is
+// running, or there would be no interrupt.
+void pwmdoubleout_store_retune( pwmdoubleout_t* obj, int reg_value ) {
+	pwmdoubleout_store( pwmdoubleout_cache_retune( reg_value ) );
 }
 
 // Set the PWM period, keeping the duty cycle the same.
 void pwmdoubleout_period_us( pwmdoubleout_t* obj, int us ) {
 	// calculate number of ticks
-	uint32_t ticks = pwm_clock_mhz * us;
-
-	// set reset
-	LPC_PWM1->TCR = TCR_RESET;
-
-	// set the global match register
-	LPC_PWM1->MR0 = ticks;
-
-	// Scale the pulse width to preserve the duty ratio
-	if ( LPC_PWM1->MR0 > 0 ) {
-		*obj->MRA = ( *obj->MRA * ticks ) / LPC_PWM1->MR0;
-		*obj->MRB = ( *obj->MRB * ticks ) / LPC_PWM1->MR0;
-	}
-
-	// set the channel latch to update value at next period start
-	// LPC_PWM1->LER |= ( 1 << 0 ) | ( 1 << ( obj->pwm - 1 ) ) | ( 1 << obj->pwm );
-	LPC_PWM1->LER |=  1 << 0  ;
-
-	// enable counter and pwm, clear reset
-	LPC_PWM1->TCR = TCR_CNT_EN | TCR_PWM_EN;
+	pwmdoubleout_retune( obj, pwmdoubleout_us_ticks( us ) );
 }
 
 void pwmdoubleout_pulsewidth( pwmdoubleout_t* obj, float seconds ) {
@@ -303,16 +918,5 @@ void pwmdoubleout_pulsewidth_ms( pwmdoubleout_t* obj, int ms ) {
 
 void pwmdoubleout_pulsewidth_us( pwmdoubleout_t* obj, int us ) {
 	// calculate number of ticks
-	uint32_t v = pwm_clock_mhz * us;
-
-	// workaround for PWM1[1] - Never make it equal MR0, else we get 1 cycle dropout
-	if ( v == LPC_PWM1->MR0 ) {
-		v++;
-	}
-
-	// set the match register value
-	*obj->MRB = *obj->MRA + v;
-
-	// set the channel latch to update value at next period start
-	LPC_PWM1->LER |= 1 << obj->pwm;
+	pwmdoubleout_set_duty_cycle( obj, pwmdoubleout_us_ticks( us ) );
 }
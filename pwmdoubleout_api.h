@@ -17,6 +17,8 @@
 #define MBED_PWMDOUBLEOUT_API_H
 
 #include "device.h"
+#include "cmsis.h"
+#include "mbed_assert.h"
 
 #if DEVICE_PWMDOUBLEOUT
 
@@ -26,13 +28,43 @@ extern "C" {
 
 typedef struct pwmdoubleout_s pwmdoubleout_t;
 
+/** Handler called from the PWM1 interrupt at every period start */
+typedef void ( *pwmdoubleout_irq_handler )( uintptr_t id );
+
+/** Q16 representation of one full period (100% duty, 360 degrees) */
+#define PWMDOUBLEOUT_Q16_ONE 0x10000
+
+/** Fractional bits of the dithered rise and width */
+#define PWMDOUBLEOUT_DITHER_BITS 8
+
+/** NVIC priority of the PWM1 period interrupt, the most urgent. Handlers
+ *  of other interrupts that can run for longer than a period must be given
+ *  a lower one (a higher number), or they delay bursts, dither and ramps. */
+#define PWMDOUBLEOUT_IRQ_PRIORITY 0
+
+/** Largest PR + 1 the planner tries */
+#define PWMDOUBLEOUT_PLAN_MAX_PRESCALE 256
+
+/** PWM1 timing chosen by pwmdoubleout_plan() */
+typedef struct {
+	uint32_t pclk_div;   /**< CCLK divider selected in PCLKSEL0: 1, 2, 4 or 8 */
+	uint32_t prescale;   /**< Timer ticks per PCLK, PR + 1 */
+	uint32_t period;     /**< MR0, which is also the number of duty/phase steps */
+	uint32_t freq_hz;    /**< Achieved frequency, rounded */
+	int32_t  error_ppm;  /**< Achieved versus requested frequency */
+} pwmdoubleout_plan_t;
+
 void pwmdoubleout_init         ( pwmdoubleout_t* obj, PinName pin );
 void pwmdoubleout_free         ( pwmdoubleout_t* obj );
 
 void  pwmdoubleout_write       ( pwmdoubleout_t* obj, float percent );
 float pwmdoubleout_read        ( pwmdoubleout_t* obj );
 
+void     pwmdoubleout_write_q16  ( pwmdoubleout_t* obj, uint32_t fraction );
+uint32_t pwmdoubleout_read_q16   ( pwmdoubleout_t* obj );
+
 void pwmdoubleout_dephase      ( pwmdoubleout_t* obj, float percent );
+void pwmdoubleout_dephase_q16  ( pwmdoubleout_t* obj, uint32_t fraction );
 
 void pwmdoubleout_period       ( pwmdoubleout_t* obj, float seconds );
 void pwmdoubleout_period_ms    ( pwmdoubleout_t* obj, int ms );
@@ -45,8 +77,179 @@ void pwmdoubleout_pulsewidth_ms( pwmdoubleout_t* obj, int ms );
 void pwmdoubleout_pulsewidth_us( pwmdoubleout_t* obj, int us );
 
 void pwmdoubleout_set_freq ( pwmdoubleout_t* obj, int reg_value );
+void pwmdoubleout_retune   ( pwmdoubleout_t* obj, int reg_value );
+void pwmdoubleout_store_retune ( pwmdoubleout_t* obj, int reg_value );
 void pwmdoubleout_set_duty_cycle ( pwmdoubleout_t* obj, int reg_value );
+void pwmdoubleout_store_duty_cycle ( pwmdoubleout_t* obj, int reg_value );
 void pwmdoubleout_set_dephase ( pwmdoubleout_t* obj, int reg_value );
+void pwmdoubleout_store_dephase ( pwmdoubleout_t* obj, int reg_value );
+void pwmdoubleout_set_edges   ( pwmdoubleout_t* obj, int reg_rise, int width );
+
+void pwmdoubleout_dither       ( pwmdoubleout_t* obj, uint32_t rise, uint32_t width );
+void pwmdoubleout_dither_stop  ( pwmdoubleout_t* obj );
+
+int  pwmdoubleout_burst        ( pwmdoubleout_t* obj, uint32_t count, uint32_t interval,
+                                 pwmdoubleout_irq_handler done, uintptr_t id );
+void pwmdoubleout_burst_stop   ( pwmdoubleout_t* obj );
+int  pwmdoubleout_burst_active ( pwmdoubleout_t* obj );
+
+unsigned int pwmdoubleout_clock_mhz( void );
+uint32_t     pwmdoubleout_clock_hz ( void );
+
+int  pwmdoubleout_plan         ( pwmdoubleout_plan_t* plan, uint32_t freq_hz, uint32_t min_steps );
+void pwmdoubleout_apply_plan   ( const pwmdoubleout_plan_t* plan );
+
+void pwmdoubleout_group_begin  ( void );
+void pwmdoubleout_group_commit ( void );
+
+void pwmdoubleout_load_match   ( const uint32_t* match, uint32_t mask );
+void pwmdoubleout_store_match  ( const uint32_t* match, uint32_t mask );
+
+int  pwmdoubleout_irq_attach   ( pwmdoubleout_irq_handler handler, uintptr_t id );
+void pwmdoubleout_irq_detach   ( pwmdoubleout_irq_handler handler, uintptr_t id );
+uint32_t pwmdoubleout_irq_elapsed( void );
+uint32_t pwmdoubleout_irq_overruns( void );
+
+/*
+ * Driver state, shared with the inline setters of StaticPwmDoubleOut.
+ * pwmdoubleout_match mirrors MR0..MR6, pwmdoubleout_width holds the pulse
+ * width of each channel in ticks. While pwmdoubleout_group_depth is non
+ * zero, changed match registers are collected in pwmdoubleout_group_mask
+ * instead of being stored. pwmdoubleout_base_* keep each channel's edges
+ * as last set in ticks and the period they were set against: rescaling to
+ * a new period starts from them, so rounding does not build up.
+ * pwmdoubleout_irq_used counts the period interrupt handlers attached.
+ */
+extern uint32_t pwmdoubleout_match[7];
+extern uint32_t pwmdoubleout_width[7];
+extern uint32_t pwmdoubleout_base_rise[7];
+extern uint32_t pwmdoubleout_base_width[7];
+extern uint32_t pwmdoubleout_base_period[7];
+extern unsigned int pwmdoubleout_group_depth;
+extern uint32_t pwmdoubleout_group_mask;
+extern unsigned int pwmdoubleout_irq_used;
+
+// Set LER bits from the main context. Handlers of the period interrupt set
+// bits of their own, and one taken between the read and the write of LER
+// would have them overwritten: its edges would never latch. So while any
+// is attached the interrupt is masked for the update. Not to be used with
+// it masked already.
+static inline void pwmdoubleout_ler_set( uint32_t mask ) {
+	if ( pwmdoubleout_irq_used ) {
+		NVIC_DisableIRQ( PWM1_IRQn );
+		LPC_PWM1->LER |= mask;
+		NVIC_EnableIRQ( PWM1_IRQn );
+	} else {
+		LPC_PWM1->LER |= mask;
+	}
+}
+
+// Fall edge of a pulse of 'width' ticks rising at 'rise', wrapped into the period
+static inline uint32_t pwmdoubleout_fall( uint32_t rise, uint32_t width,
+        uint32_t period ) {
+	if ( width >= period ) {
+		// out of range, never matches: the output stays set
+		return period + 1;
+	}
+	uint32_t fall = rise + width;
+	if ( fall >= period ) {
+		//wraparound
+		fall -= period;
+	}
+	//workaround; a fall at 1 would coincide with a rise at 1 and cancel
+	//the pulse, so that one is left set instead
+	if ( rise != 0 && fall == 0 ) {
+		fall = ( rise == 1 ) ? period + 1 : 1;
+	}
+	return fall;
+}
+
+// Fold a rise edge into [0, period)
+static inline uint32_t pwmdoubleout_wrap( uint32_t rise, uint32_t period ) {
+	if ( rise >= period ) {
+		rise = ( period > 0 ) ? rise % period : 0;
+	}
+	return rise;
+}
+
+// Scale a Q16 fraction of the period to ticks with a multiply and a shift
+static inline int pwmdoubleout_q16_ticks( uint32_t fraction ) {
+	if ( fraction > PWMDOUBLEOUT_Q16_ONE ) {
+		fraction = PWMDOUBLEOUT_Q16_ONE;
+	}
+	return ( int )( ( ( uint64_t )pwmdoubleout_match[0] * fraction ) >> 16 );
+}
+
+// Pulse width of channel pwm as a Q16 fraction of the period
+static inline uint32_t pwmdoubleout_width_q16( int pwm ) {
+	uint32_t width = pwmdoubleout_width[pwm];
+	if ( width >= pwmdoubleout_match[0] ) {
+		return PWMDOUBLEOUT_Q16_ONE;
+	}
+	return ( uint32_t )( ( ( uint64_t )width << 16 ) / pwmdoubleout_match[0] );
+}
+
+/*
+ * Edge arithmetic shared by the driver setters and StaticPwmDoubleOut: each
+ * updates the cache of channel pwm and returns the mask of the match
+ * registers that have to be stored.
+ */
+
+// Take the channel's cached edges as the ones later periods scale from
+static inline void pwmdoubleout_cache_base( int pwm ) {
+	pwmdoubleout_base_rise[pwm] = pwmdoubleout_match[pwm - 1];
+	pwmdoubleout_base_width[pwm] = pwmdoubleout_width[pwm];
+	pwmdoubleout_base_period[pwm] = pwmdoubleout_match[0];
+}
+
+// New pulse width, keeping the rise edge; a rise left beyond a shorter
+// period is folded back into it
+static inline uint32_t pwmdoubleout_cache_duty( int pwm, int reg_value ) {
+	uint32_t period = pwmdoubleout_match[0];
+	uint32_t width = ( reg_value < 0 ) ? 0 : ( uint32_t )reg_value;
+	uint32_t rise = pwmdoubleout_match[pwm - 1];
+	uint32_t mask = 1 << pwm;
+	if ( rise >= period ) {
+		rise = pwmdoubleout_wrap( rise, period );
+		pwmdoubleout_match[pwm - 1] = rise;
+		mask |= 1 << ( pwm - 1 );
+	}
+	pwmdoubleout_width[pwm] = width;
+	pwmdoubleout_match[pwm] = pwmdoubleout_fall( rise, width, period );
+	pwmdoubleout_cache_base( pwm );
+	return mask;
+}
+
+// Both edges in one pass: rise at reg_rise, fall width ticks later
+static inline uint32_t pwmdoubleout_cache_edges( int pwm, int reg_rise, int width ) {
+	uint32_t period = pwmdoubleout_match[0];
+	uint32_t rise = pwmdoubleout_wrap( ( reg_rise < 0 ) ? 0 : ( uint32_t )reg_rise, period );
+	uint32_t ticks = ( width < 0 ) ? 0 : ( uint32_t )width;
+	pwmdoubleout_width[pwm] = ticks;
+	pwmdoubleout_match[pwm - 1] = rise;
+	pwmdoubleout_match[pwm] = pwmdoubleout_fall( rise, ticks, period );
+	pwmdoubleout_cache_base( pwm );
+	return ( 1 << pwm ) | ( 1 << ( pwm - 1 ) );
+}
+
+// Check that a channel's cached edges describe its cached width. Only
+// active in debug and host builds, where MBED_ASSERT is compiled in.
+static inline void pwmdoubleout_check( int pwm ) {
+	uint32_t period = pwmdoubleout_match[0];
+	uint32_t rise = pwmdoubleout_match[pwm - 1];
+	uint32_t fall = pwmdoubleout_match[pwm];
+	uint32_t width = pwmdoubleout_width[pwm];
+	( void )rise;
+	( void )fall;
+	( void )width;
+	if ( period == 0 ) {
+		return;
+	}
+	MBED_ASSERT( rise < period );
+	MBED_ASSERT( width >= period ? fall == period + 1 :
+	             fall == ( rise + width ) % period ||
+	             ( ( rise + width ) % period == 0 && fall == ( rise == 1 ? period + 1 : 1 ) ) );
+}
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,112 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_CMSIS_H
+#define MBED_CMSIS_H
+
+/*
+ * Host stand-in for the LPC17xx CMSIS device header. Only the peripherals
+ * the PWM double edge driver touches are described; LPC_PWM1 and LPC_SC
+ * resolve to plain memory that pwm1_sim.c interprets as the PWM1 block,
+ * and the DWT cycle counter is advanced by it at CCLK.
+ */
+
+#include <stdint.h>
+
+#define __I  volatile   /* read-only on the part, writable by the model */
+#define __O  volatile
+#define __IO volatile
+
+typedef enum IRQn {
+	TIMER3_IRQn = 4,
+	PWM1_IRQn = 9,
+	EINT3_IRQn = 21
+} IRQn_Type;
+
+typedef struct {
+	__IO uint32_t IR;
+	__IO uint32_t TCR;
+	__IO uint32_t TC;
+	__IO uint32_t PR;
+	__IO uint32_t PC;
+	__IO uint32_t MCR;
+	__IO uint32_t MR0;
+	__IO uint32_t MR1;
+	__IO uint32_t MR2;
+	__IO uint32_t MR3;
+	__IO uint32_t CCR;
+	__I  uint32_t CR0;
+	__I  uint32_t CR1;
+	__I  uint32_t CR2;
+	__I  uint32_t CR3;
+	uint32_t RESERVED0;
+	__IO uint32_t MR4;
+	__IO uint32_t MR5;
+	__IO uint32_t MR6;
+	__IO uint32_t PCR;
+	__IO uint32_t LER;
+	uint32_t RESERVED1[7];
+	__IO uint32_t CTCR;
+} LPC_PWM_TypeDef;
+
+// Subset of the system control block: power and peripheral clock selection
+typedef struct {
+	__IO uint32_t PCONP;
+	__IO uint32_t PCLKSEL0;
+	__IO uint32_t PCLKSEL1;
+} LPC_SC_TypeDef;
+
+// Subset of the core debug block and the DWT: the cycle counter
+typedef struct {
+	__IO uint32_t DHCSR;
+	__O  uint32_t DCRSR;
+	__IO uint32_t DCRDR;
+	__IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+	__IO uint32_t CTRL;
+	__IO uint32_t CYCCNT;
+} DWT_Type;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern LPC_PWM_TypeDef pwm1_sim_regs;
+extern LPC_SC_TypeDef  sc_sim_regs;
+extern CoreDebug_Type  core_debug_sim_regs;
+extern DWT_Type        dwt_sim_regs;
+extern uint32_t SystemCoreClock;
+
+void     NVIC_EnableIRQ  ( IRQn_Type irq );
+void     NVIC_DisableIRQ ( IRQn_Type irq );
+void     NVIC_SetPriority( IRQn_Type irq, uint32_t priority );
+uint32_t NVIC_GetPriority( IRQn_Type irq );
+
+// One thread of execution on the host: interrupts are function calls
+static inline void __disable_irq( void ) {}
+static inline void __enable_irq( void ) {}
+
+#ifdef __cplusplus
+}
+#endif
+
+#define LPC_PWM1  ( &pwm1_sim_regs )
+#define LPC_SC    ( &sc_sim_regs )
+#define CoreDebug ( &core_debug_sim_regs )
+#define DWT       ( &dwt_sim_regs )
+
+#endif
@@ -0,0 +1,94 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_DEVICE_H
+#define MBED_DEVICE_H
+
+/*
+ * Host stand-in for the target's device.h, PinNames.h, PeripheralNames.h
+ * and objects.h, reduced to what the PWM double edge driver needs.
+ */
+
+#include <stdint.h>
+#include "cmsis.h"
+
+#define DEVICE_PWMDOUBLEOUT 1
+
+#define PORT_SHIFT 5
+
+typedef enum {
+	P0_15 = ( 0 << PORT_SHIFT ) | 15,
+	P0_16 = ( 0 << PORT_SHIFT ) | 16,
+	P0_17 = ( 0 << PORT_SHIFT ) | 17,
+	P0_18 = ( 0 << PORT_SHIFT ) | 18,
+	P0_23 = ( 0 << PORT_SHIFT ) | 23,
+	P0_24 = ( 0 << PORT_SHIFT ) | 24,
+	P0_25 = ( 0 << PORT_SHIFT ) | 25,
+	P0_26 = ( 0 << PORT_SHIFT ) | 26,
+	P1_18 = ( 1 << PORT_SHIFT ) | 18,
+	P1_20 = ( 1 << PORT_SHIFT ) | 20,
+	P1_21 = ( 1 << PORT_SHIFT ) | 21,
+	P1_23 = ( 1 << PORT_SHIFT ) | 23,
+	P1_24 = ( 1 << PORT_SHIFT ) | 24,
+	P1_26 = ( 1 << PORT_SHIFT ) | 26,
+	P1_30 = ( 1 << PORT_SHIFT ) | 30,
+	P1_31 = ( 1 << PORT_SHIFT ) | 31,
+	P2_0  = ( 2 << PORT_SHIFT ) | 0,
+	P2_1  = ( 2 << PORT_SHIFT ) | 1,
+	P2_2  = ( 2 << PORT_SHIFT ) | 2,
+	P2_3  = ( 2 << PORT_SHIFT ) | 3,
+	P2_4  = ( 2 << PORT_SHIFT ) | 4,
+	P2_5  = ( 2 << PORT_SHIFT ) | 5,
+	P3_25 = ( 3 << PORT_SHIFT ) | 25,
+	P3_26 = ( 3 << PORT_SHIFT ) | 26,
+
+	// mbed DIP pin names
+	p11 = P0_18,
+	p12 = P0_17,
+	p13 = P0_15,
+	p14 = P0_16,
+	p15 = P0_23,
+	p16 = P0_24,
+	p17 = P0_25,
+	p18 = P0_26,
+	p19 = P1_30,
+	p20 = P1_31,
+	p21 = P2_5,
+	p22 = P2_4,
+	p23 = P2_3,
+	p24 = P2_2,
+	p25 = P2_1,
+	p26 = P2_0,
+
+	// Not connected
+	NC = ( int )0xFFFFFFFF
+} PinName;
+
+typedef enum {
+	PWM_1 = 1,
+	PWM_2,
+	PWM_3,
+	PWM_4,
+	PWM_5,
+	PWM_6
+} PWMName;
+
+struct pwmdoubleout_s {
+	PWMName pwm;
+	__IO uint32_t *MRA;
+	__IO uint32_t *MRB;
+};
+
+#endif
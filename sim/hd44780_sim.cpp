@@ -0,0 +1,121 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "hd44780_sim.h"
+
+static PinName pin_rs, pin_e, pin_d[4];
+static int level_e;
+static int four_bit;
+static int high_nibble;  // -1 while waiting for the first nibble of a byte
+static uint32_t nibbles;
+static uint32_t commands;
+static uint32_t data;
+static char ddram[128];
+static uint8_t address;
+
+static void instruction( uint8_t value ) {
+	commands++;
+	if ( value & 0x80 ) {
+		address = value & 0x7f;
+	} else if ( value & 0x40 ) {
+		// character generator RAM, not modelled
+	} else if ( value & 0x20 ) {
+		// function set: DL selects the bus width
+		four_bit = !( value & 0x10 );
+	} else if ( value == 0x01 ) {
+		memset( ddram, ' ', sizeof( ddram ) );
+		address = 0;
+	} else if ( ( value & 0xfe ) == 0x02 ) {
+		address = 0;
+	}
+	// entry mode, display control and shifts: increment mode assumed
+}
+
+static void receive( uint8_t value, int rs ) {
+	if ( rs ) {
+		data++;
+		ddram[address] = value;
+		address = ( address + 1 ) & 0x7f;
+	} else {
+		instruction( value );
+	}
+}
+
+static void output( PinName pin, int value ) {
+	if ( pin != pin_e ) {
+		return;
+	}
+	int falling = level_e && !value;
+	level_e = value;
+	if ( !falling ) {
+		return;
+	}
+	nibbles++;
+	uint8_t nibble = 0;
+	for ( int i = 0; i < 4; i++ ) {
+		nibble |= mbed_sim_pin_read( pin_d[i] ) << i;
+	}
+	int rs = mbed_sim_pin_read( pin_rs );
+	if ( !four_bit ) {
+		// D0..D3 are not wired: the low half of an 8-bit write reads as 0
+		receive( nibble << 4, rs );
+		high_nibble = -1;
+	} else if ( high_nibble < 0 ) {
+		high_nibble = nibble;
+	} else {
+		receive( ( high_nibble << 4 ) | nibble, rs );
+		high_nibble = -1;
+	}
+}
+
+void hd44780_sim_attach( PinName rs, PinName e, PinName d4, PinName d5,
+                         PinName d6, PinName d7 ) {
+	pin_rs = rs;
+	pin_e = e;
+	pin_d[0] = d4;
+	pin_d[1] = d5;
+	pin_d[2] = d6;
+	pin_d[3] = d7;
+	level_e = mbed_sim_pin_read( e );
+	four_bit = 0;
+	high_nibble = -1;
+	nibbles = commands = data = 0;
+	memset( ddram, ' ', sizeof( ddram ) );
+	address = 0;
+	mbed_sim_attach_output( output );
+}
+
+uint32_t hd44780_sim_nibbles( void ) {
+	return nibbles;
+}
+
+uint32_t hd44780_sim_commands( void ) {
+	return commands;
+}
+
+uint32_t hd44780_sim_data( void ) {
+	return data;
+}
+
+void hd44780_sim_read( uint8_t from, char* text, int count ) {
+	for ( int i = 0; i < count; i++ ) {
+		text[i] = ddram[( from + i ) & 0x7f];
+	}
+	text[count] = 0;
+}
+
+uint8_t hd44780_sim_address( void ) {
+	return address;
+}
@@ -0,0 +1,47 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HD44780_SIM_H
+#define HD44780_SIM_H
+
+/*
+ * Host model of an HD44780 character panel on a 4-bit bus.
+ *
+ * It watches the pins given to hd44780_sim_attach() through the mbed host
+ * model and latches RS and D4..D7 on every falling edge of E. The panel
+ * starts in 8-bit mode, as after power-up, until a function set selects
+ * the 4-bit bus; from then on two nibbles make one byte, high first.
+ * Attach before the TextLCD is constructed so the model sees its
+ * initialisation sequence.
+ */
+
+#include "mbed.h"
+
+void     hd44780_sim_attach( PinName rs, PinName e, PinName d4, PinName d5,
+                             PinName d6, PinName d7 );
+
+// Falling edges of E, i.e. nibbles (or 8-bit writes) clocked in
+uint32_t hd44780_sim_nibbles( void );
+// Instruction and data bytes received
+uint32_t hd44780_sim_commands( void );
+uint32_t hd44780_sim_data( void );
+
+// Copy count characters of display RAM from address, e.g. 0x40 for the
+// second row, and zero terminate
+void     hd44780_sim_read( uint8_t address, char* text, int count );
+// Address counter, where the cursor is shown
+uint8_t  hd44780_sim_address( void );
+
+#endif
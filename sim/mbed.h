@@ -0,0 +1,239 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_H
+#define MBED_H
+
+/*
+ * Host stand-in for the parts of the mbed library that main.cpp and
+ * TextLCD use: digital pins, the encoder pin interrupts, Timeout, Stream
+ * and the blocking waits.
+ *
+ * Pins are plain levels kept by mbed_sim.cpp. A test drives inputs with
+ * mbed_sim_pin_write(), which runs the InterruptIn handlers of that pin
+ * synchronously as the GPIO interrupt would, and watches outputs through
+ * mbed_sim_attach_output(). Time only moves in mbed_sim_run_us() and in
+ * the waits, which fire the Timeouts that fall due on the way;
+ * us_ticker_read() returns that time.
+ */
+
+#include "platform.h"
+#include "mbed_assert.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef enum {
+	PullUp,
+	PullDown,
+	PullNone,
+	OpenDrain
+} PinMode;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t us_ticker_read( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+void wait( float s );
+void wait_ms( int ms );
+void wait_us( int us );
+
+// Host model controls
+void     mbed_sim_pin_write( PinName pin, int value );
+int      mbed_sim_pin_read( PinName pin );
+void     mbed_sim_attach_output( void ( *hook )( PinName pin, int value ) );
+void     mbed_sim_run_us( uint32_t us );
+uint64_t mbed_sim_now_us( void );
+int      mbed_sim_timeouts( void );
+
+namespace mbed {
+
+class DigitalOut {
+public:
+	DigitalOut( PinName pin ) : _pin( pin ) {}
+	void write( int value ) {
+		mbed_sim_pin_write( _pin, value ? 1 : 0 );
+	}
+	int read() {
+		return mbed_sim_pin_read( _pin );
+	}
+	DigitalOut& operator= ( int value ) {
+		write( value );
+		return *this;
+	}
+	operator int() {
+		return read();
+	}
+
+protected:
+	PinName _pin;
+};
+
+class DigitalIn {
+public:
+	DigitalIn( PinName pin ) : _pin( pin ) {}
+	int read() {
+		return mbed_sim_pin_read( _pin );
+	}
+	void mode( PinMode pull ) {
+		( void )pull;
+	}
+	operator int() {
+		return read();
+	}
+
+protected:
+	PinName _pin;
+};
+
+class BusOut {
+public:
+	BusOut( PinName p0, PinName p1 = NC, PinName p2 = NC, PinName p3 = NC ) {
+		_pin[0] = p0;
+		_pin[1] = p1;
+		_pin[2] = p2;
+		_pin[3] = p3;
+	}
+	void write( int value ) {
+		for ( int i = 0; i < 4; i++ ) {
+			if ( _pin[i] != NC ) {
+				mbed_sim_pin_write( _pin[i], ( value >> i ) & 1 );
+			}
+		}
+	}
+	BusOut& operator= ( int value ) {
+		write( value );
+		return *this;
+	}
+
+protected:
+	PinName _pin[4];
+};
+
+class InterruptIn {
+public:
+	InterruptIn( PinName pin );
+	~InterruptIn();
+	int read() {
+		return mbed_sim_pin_read( _pin );
+	}
+	void mode( PinMode pull ) {
+		( void )pull;
+	}
+	void rise( void ( *fptr )( void ) ) {
+		_rise = fptr;
+	}
+	void fall( void ( *fptr )( void ) ) {
+		_fall = fptr;
+	}
+	operator int() {
+		return read();
+	}
+
+	// Called by the model on a level change of the pin
+	void edge( int value );
+
+protected:
+	friend void ::mbed_sim_pin_write( PinName pin, int value );
+
+	PinName _pin;
+	void ( *_rise )( void );
+	void ( *_fall )( void );
+	InterruptIn* _next;
+};
+
+class Timeout {
+public:
+	Timeout();
+	~Timeout();
+	void attach_us( void ( *fptr )( void ), uint32_t us ) {
+		_function = fptr;
+		_thunk = &Timeout::call_function;
+		schedule( us );
+	}
+	template<typename T>
+	void attach_us( T* object, void ( T::*member )( void ), uint32_t us ) {
+		static_assert( sizeof( member ) <= sizeof( _member ), "member pointer too large" );
+		_object = object;
+		memcpy( _member, ( char* )&member, sizeof( member ) );
+		_thunk = &Timeout::call_member<T>;
+		schedule( us );
+	}
+	void attach( void ( *fptr )( void ), float s ) {
+		attach_us( fptr, ( uint32_t )( s * 1000000.0f ) );
+	}
+	void detach();
+
+	// Called by the model when the timeout falls due
+	void fire();
+	uint64_t due() const {
+		return _due;
+	}
+	bool armed() const {
+		return _armed;
+	}
+
+protected:
+	friend void ::mbed_sim_run_us( uint32_t us );
+	friend int ::mbed_sim_timeouts( void );
+
+	void schedule( uint32_t us );
+	static void call_function( Timeout* t ) {
+		t->_function();
+	}
+	template<typename T>
+	static void call_member( Timeout* t ) {
+		void ( T::*member )( void );
+		memcpy( ( char* )&member, t->_member, sizeof( member ) );
+		( ( ( T* )t->_object )->*member )();
+	}
+
+	void ( *_thunk )( Timeout* t );
+	void ( *_function )( void );
+	void* _object;
+	char _member[16];
+	uint64_t _due;
+	bool _armed;
+	Timeout* _next;
+};
+
+class Stream {
+public:
+	virtual ~Stream() {}
+	int putc( int c ) {
+		return _putc( c );
+	}
+	int getc() {
+		return _getc();
+	}
+	int puts( const char* s );
+	int printf( const char* format, ... );
+
+protected:
+	virtual int _putc( int c ) = 0;
+	virtual int _getc() = 0;
+};
+
+} // namespace mbed
+
+using namespace mbed;
+
+#endif
@@ -0,0 +1,195 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include <stdarg.h>
+
+/*
+ * Pin levels, the InterruptIn and Timeout lists and the time base behind
+ * the host mbed.h. Everything runs in the calling thread: an input edge
+ * runs its handlers before mbed_sim_pin_write() returns, a Timeout runs
+ * inside the mbed_sim_run_us() or wait() that reaches it.
+ */
+
+#define MBED_SIM_PINS 64
+
+static struct {
+	PinName pin;
+	int level;
+} pins[MBED_SIM_PINS];
+static int pin_count;
+
+static InterruptIn* interrupts;
+static Timeout* timeouts;
+static uint64_t now_us;
+static void ( *output_hook )( PinName pin, int value );
+
+// Level slot of a pin; inputs float high (every button has a pull-up)
+static int pin_slot( PinName pin ) {
+	for ( int i = 0; i < pin_count; i++ ) {
+		if ( pins[i].pin == pin ) {
+			return i;
+		}
+	}
+	MBED_ASSERT( pin_count < MBED_SIM_PINS );
+	pins[pin_count].pin = pin;
+	pins[pin_count].level = 1;
+	return pin_count++;
+}
+
+void mbed_sim_pin_write( PinName pin, int value ) {
+	int slot = pin_slot( pin );
+	int old = pins[slot].level;
+	pins[slot].level = value;
+	if ( output_hook ) {
+		output_hook( pin, value );
+	}
+	if ( value != old ) {
+		for ( InterruptIn* in = interrupts; in; in = in->_next ) {
+			if ( in->_pin == pin ) {
+				in->edge( value );
+			}
+		}
+	}
+}
+
+int mbed_sim_pin_read( PinName pin ) {
+	return pins[pin_slot( pin )].level;
+}
+
+void mbed_sim_attach_output( void ( *hook )( PinName pin, int value ) ) {
+	output_hook = hook;
+}
+
+void mbed_sim_run_us( uint32_t us ) {
+	uint64_t end = now_us + us;
+	for ( ;; ) {
+		Timeout* next = 0;
+		for ( Timeout* t = timeouts; t; t = t->_next ) {
+			if ( t->armed() && t->due() <= end && ( !next || t->due() < next->due() ) ) {
+				next = t;
+			}
+		}
+		if ( !next ) {
+			break;
+		}
+		if ( next->due() > now_us ) {
+			now_us = next->due();
+		}
+		next->fire();
+	}
+	now_us = end;
+}
+
+uint64_t mbed_sim_now_us( void ) {
+	return now_us;
+}
+
+int mbed_sim_timeouts( void ) {
+	int armed = 0;
+	for ( Timeout* t = timeouts; t; t = t->_next ) {
+		armed += t->armed();
+	}
+	return armed;
+}
+
+uint32_t us_ticker_read( void ) {
+	return ( uint32_t )now_us;
+}
+
+void wait( float s ) {
+	mbed_sim_run_us( ( uint32_t )( s * 1000000.0f ) );
+}
+
+void wait_ms( int ms ) {
+	mbed_sim_run_us( ms * 1000 );
+}
+
+void wait_us( int us ) {
+	mbed_sim_run_us( us );
+}
+
+namespace mbed {
+
+InterruptIn::InterruptIn( PinName pin ) : _pin( pin ), _rise( 0 ), _fall( 0 ) {
+	_next = interrupts;
+	interrupts = this;
+}
+
+InterruptIn::~InterruptIn() {
+	for ( InterruptIn** p = &interrupts; *p; p = &( *p )->_next ) {
+		if ( *p == this ) {
+			*p = _next;
+			break;
+		}
+	}
+}
+
+void InterruptIn::edge( int value ) {
+	void ( *handler )( void ) = value ? _rise : _fall;
+	if ( handler ) {
+		handler();
+	}
+}
+
+Timeout::Timeout() : _thunk( 0 ), _function( 0 ), _object( 0 ), _due( 0 ), _armed( false ) {
+	_next = timeouts;
+	timeouts = this;
+}
+
+Timeout::~Timeout() {
+	for ( Timeout** p = &timeouts; *p; p = &( *p )->_next ) {
+		if ( *p == this ) {
+			*p = _next;
+			break;
+		}
+	}
+}
+
+void Timeout::schedule( uint32_t us ) {
+	_due = now_us + us;
+	_armed = true;
+}
+
+void Timeout::detach() {
+	_armed = false;
+}
+
+void Timeout::fire() {
+	// one shot: the handler may attach again
+	_armed = false;
+	_thunk( this );
+}
+
+int Stream::puts( const char* s ) {
+	while ( *s ) {
+		_putc( *s++ );
+	}
+	return 0;
+}
+
+int Stream::printf( const char* format, ... ) {
+	char buffer[256];
+	va_list args;
+	va_start( args, format );
+	int n = vsnprintf( buffer, sizeof( buffer ), format, args );
+	va_end( args );
+	for ( int i = 0; i < n && i < ( int )sizeof( buffer ) - 1; i++ ) {
+		_putc( buffer[i] );
+	}
+	return n;
+}
+
+} // namespace mbed
@@ -0,0 +1,251 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string.h>
+#include "cmsis.h"
+#include "pwm1_sim.h"
+
+#define TCR_CNT_EN       0x00000001
+#define TCR_RESET        0x00000002
+#define TCR_PWM_EN       0x00000008
+
+#define MCR_MR0_INT      0x00000001
+
+#define DWT_CTRL_CYCCNT  0x00000001
+
+void PWM1_IRQHandler( void ) __attribute__( ( weak ) );
+
+static __IO uint32_t* const shadow[] = {
+	&( LPC_PWM1->MR0 ),
+	&( LPC_PWM1->MR1 ),
+	&( LPC_PWM1->MR2 ),
+	&( LPC_PWM1->MR3 ),
+	&( LPC_PWM1->MR4 ),
+	&( LPC_PWM1->MR5 ),
+	&( LPC_PWM1->MR6 )
+};
+
+static uint32_t active[7];      // values the comparators currently use
+static int      output[7];
+static uint32_t tc;
+static uint32_t pc;
+static uint32_t tcr_seen;
+static uint64_t now;
+static uint32_t periods;
+static pwm1_sim_edge_handler edge_handler;
+static uint64_t irq_latency;
+static uint64_t irq_at;
+static int      irq_pending;
+
+// CCLK cycles per PCLK cycle, from the PWM1 field of PCLKSEL0
+static uint32_t pwm1_sim_pclk_div( void ) {
+	static const uint32_t dividers[] = { 4, 1, 2, 8 };
+	return dividers[( LPC_SC->PCLKSEL0 >> 12 ) & 0x3];
+}
+
+// Let time pass up to t, running the cycle counter along
+static void pwm1_sim_advance( uint64_t t ) {
+	if ( DWT->CTRL & DWT_CTRL_CYCCNT ) {
+		DWT->CYCCNT += ( uint32_t )( ( t - now ) * pwm1_sim_pclk_div() );
+	}
+	now = t;
+}
+
+static void pwm1_sim_irq( void ) {
+	if ( pwm1_sim_irq_enabled() && PWM1_IRQHandler ) {
+		PWM1_IRQHandler();
+	}
+}
+
+static void pwm1_sim_latch( void ) {
+	uint32_t ler = LPC_PWM1->LER;
+	for ( int i = 0; i < 7; i++ ) {
+		if ( ler & ( 1 << i ) ) {
+			active[i] = *shadow[i];
+		}
+	}
+	LPC_PWM1->LER = 0;
+}
+
+static void pwm1_sim_match( uint32_t t ) {
+	uint32_t pcr = LPC_PWM1->PCR;
+	for ( int n = 1; n <= 6; n++ ) {
+		int level = output[n];
+		if ( n >= 2 && ( pcr & ( 1 << n ) ) ) {
+			// double edge: set by MR(n-1), cleared by MRn
+			if ( active[n - 1] == t ) {
+				level = 1;
+			}
+		} else if ( t == 0 && active[n] != 0 ) {
+			level = 1;
+		}
+		if ( active[n] == t ) {
+			level = 0;
+		}
+		if ( !( pcr & ( 1 << ( 8 + n ) ) ) ) {
+			level = 0;
+		}
+		if ( level != output[n] ) {
+			output[n] = level;
+			if ( edge_handler ) {
+				edge_handler( n, level, now );
+			}
+		}
+	}
+}
+
+static void pwm1_sim_period_start( int match0 ) {
+	tc = 0;
+	pc = 0;
+	LPC_PWM1->TC = 0;
+	pwm1_sim_latch();
+	pwm1_sim_match( 0 );
+	if ( !match0 ) {
+		return;
+	}
+	periods++;
+	if ( LPC_PWM1->MCR & MCR_MR0_INT ) {
+		LPC_PWM1->IR |= 1 << 0;
+		if ( irq_pending ) {
+			// still waiting: this match is coalesced into it
+		} else if ( irq_latency == 0 ) {
+			pwm1_sim_irq();
+		} else {
+			irq_pending = 1;
+			irq_at = now + irq_latency;
+		}
+	}
+}
+
+// Pick up TCR changes made by the driver since the model last ran
+static void pwm1_sim_sync( void ) {
+	uint32_t tcr = LPC_PWM1->TCR;
+	if ( !( tcr & TCR_PWM_EN ) ) {
+		// timer mode: match registers are not shadowed
+		for ( int i = 0; i < 7; i++ ) {
+			active[i] = *shadow[i];
+		}
+	}
+	if ( tcr & TCR_RESET ) {
+		tc = 0;
+		pc = 0;
+		LPC_PWM1->TC = 0;
+	} else if ( ( tcr & TCR_CNT_EN ) &&
+	            ( !( tcr_seen & TCR_CNT_EN ) || ( tcr_seen & TCR_RESET ) ) ) {
+		pwm1_sim_period_start( 0 );
+	}
+	tcr_seen = tcr;
+}
+
+static uint32_t pwm1_sim_next_event( void ) {
+	uint32_t next = active[0];
+	for ( int i = 1; i < 7; i++ ) {
+		if ( active[i] > tc && active[i] < next ) {
+			next = active[i];
+		}
+	}
+	return next;
+}
+
+void pwm1_sim_reset( void ) {
+	memset( ( void* )LPC_PWM1, 0, sizeof( *LPC_PWM1 ) );
+	memset( ( void* )LPC_SC, 0, sizeof( *LPC_SC ) );
+	memset( active, 0, sizeof( active ) );
+	memset( output, 0, sizeof( output ) );
+	tc = 0;
+	pc = 0;
+	tcr_seen = 0;
+	now = 0;
+	periods = 0;
+	irq_latency = 0;
+	irq_pending = 0;
+	memset( ( void* )DWT, 0, sizeof( *DWT ) );
+	memset( ( void* )CoreDebug, 0, sizeof( *CoreDebug ) );
+}
+
+void pwm1_sim_run( uint64_t pclk ) {
+	uint64_t end = now + pclk;
+	while ( now < end ) {
+		pwm1_sim_sync();
+		if ( irq_pending && irq_at <= now ) {
+			pwm1_sim_irq_flush();
+			continue;
+		}
+		// stop early for a pending interrupt
+		uint64_t limit = ( irq_pending && irq_at < end ) ? irq_at : end;
+		uint32_t tcr = LPC_PWM1->TCR;
+		if ( ( tcr & TCR_RESET ) || !( tcr & TCR_CNT_EN ) ) {
+			// counter held: time passes, nothing happens
+			pwm1_sim_advance( limit );
+			continue;
+		}
+		uint64_t scale = ( uint64_t )LPC_PWM1->PR + 1;
+		uint32_t next = ( active[0] == 0 ) ? 0 : pwm1_sim_next_event();
+		// MR0 = 0 matches on every count
+		uint64_t steps = ( active[0] == 0 ) ? 1 : next - tc;
+		uint64_t cost = steps * scale - pc;
+		if ( now + cost > limit ) {
+			uint64_t avail = limit - now + pc;
+			tc += ( uint32_t )( avail / scale );
+			pc = ( uint32_t )( avail % scale );
+			LPC_PWM1->TC = tc;
+			LPC_PWM1->PC = pc;
+			pwm1_sim_advance( limit );
+			continue;
+		}
+		pwm1_sim_advance( now + cost );
+		if ( next == active[0] ) {
+			pwm1_sim_period_start( 1 );
+		} else {
+			tc = next;
+			pc = 0;
+			LPC_PWM1->TC = tc;
+			pwm1_sim_match( tc );
+		}
+	}
+}
+
+int pwm1_sim_output( int channel ) {
+	return output[channel];
+}
+
+uint32_t pwm1_sim_active( int match ) {
+	return active[match];
+}
+
+uint64_t pwm1_sim_now( void ) {
+	return now;
+}
+
+uint32_t pwm1_sim_periods( void ) {
+	return periods;
+}
+
+void pwm1_sim_attach_edge( pwm1_sim_edge_handler handler ) {
+	edge_handler = handler;
+}
+
+void pwm1_sim_irq_latency( uint64_t pclk ) {
+	irq_latency = pclk;
+}
+
+void pwm1_sim_irq_flush( void ) {
+	if ( irq_pending ) {
+		irq_pending = 0;
+		if ( LPC_PWM1->IR & ( 1 << 0 ) ) {
+			pwm1_sim_irq();
+		}
+	}
+}
@@ -0,0 +1,74 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PWM1_SIM_H
+#define PWM1_SIM_H
+
+/*
+ * Host model of the LPC1768 PWM1 block.
+ *
+ * The driver writes the register file behind LPC_PWM1 exactly as it does
+ * on the part; pwm1_sim_run() then advances the timer by a number of PCLK
+ * cycles and interprets what it finds there:
+ *
+ *  - TC counts at PCLK / (PR + 1) and is reset by the MR0 match, so one
+ *    period lasts MR0 counts;
+ *  - writes to MR0..MR6 only reach the comparators when the matching LER
+ *    bit is set and a period starts (MR0 match, counter reset or enable);
+ *  - in double edge mode (PCR bit n) PWMn is set by MR(n-1) and cleared by
+ *    MR(n), single edge outputs are set at period start and cleared by MRn;
+ *    a simultaneous set and clear leaves the output low, a match value
+ *    above MR0 never fires;
+ *  - an MR0 match with MCR bit 0 set raises IR bit 0 and, when PWM1_IRQn is
+ *    enabled, calls PWM1_IRQHandler(). By default it is called at the match;
+ *    pwm1_sim_irq_latency() delays it, and matches while it is pending only
+ *    set IR bit 0 again, as a late interrupt does on the part. One still
+ *    pending when NVIC_DisableIRQ() masks PWM1_IRQn is taken just before,
+ *    the last moment it could come in on the part;
+ *  - while DWT->CTRL bit 0 is set, DWT->CYCCNT counts CCLK cycles, i.e.
+ *    PCLK times the PCLKSEL0 divider.
+ *
+ * Register writes are only observed between pwm1_sim_run() calls, so a
+ * TCR reset that is asserted and released without running the model in
+ * between is invisible to it.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void ( *pwm1_sim_edge_handler )( int channel, int level, uint64_t pclk );
+
+void     pwm1_sim_reset   ( void );
+void     pwm1_sim_run     ( uint64_t pclk );
+
+int      pwm1_sim_output  ( int channel );
+uint32_t pwm1_sim_active  ( int match );
+uint64_t pwm1_sim_now     ( void );
+uint32_t pwm1_sim_periods ( void );
+
+void     pwm1_sim_attach_edge( pwm1_sim_edge_handler handler );
+
+int      pwm1_sim_irq_enabled( void );
+void     pwm1_sim_irq_latency( uint64_t pclk );
+void     pwm1_sim_irq_flush  ( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "pwm1_sim.h"
+#include "pwm1_vcd.h"
+
+#define VCD_BUFFER_SIZE  65536
+#define VCD_LINE_MAX     32      // "#<20 digits>\n" plus one value change
+
+static FILE*    vcd_file;
+static char     vcd_buffer[VCD_BUFFER_SIZE];
+static size_t   vcd_used;
+static uint32_t vcd_pclk_hz;
+static uint64_t vcd_last_ns;
+static int      vcd_time_written;
+static uint64_t vcd_edges;
+
+static void pwm1_vcd_drain( void ) {
+	fwrite( vcd_buffer, 1, vcd_used, vcd_file );
+	vcd_used = 0;
+}
+
+// split so that pclk * 1e9 cannot overflow for any run length
+static uint64_t pwm1_vcd_ns( uint64_t pclk ) {
+	uint64_t seconds = pclk / vcd_pclk_hz;
+	uint64_t rest = pclk % vcd_pclk_hz;
+	return seconds * 1000000000ull + rest * 1000000000ull / vcd_pclk_hz;
+}
+
+static void pwm1_vcd_edge( int channel, int level, uint64_t pclk ) {
+	if ( vcd_used > VCD_BUFFER_SIZE - VCD_LINE_MAX ) {
+		pwm1_vcd_drain();
+	}
+	uint64_t ns = pwm1_vcd_ns( pclk );
+	if ( !vcd_time_written || ns != vcd_last_ns ) {
+		vcd_used += sprintf( vcd_buffer + vcd_used, "#%llu\n", ( unsigned long long )ns );
+		vcd_last_ns = ns;
+		vcd_time_written = 1;
+	}
+	// identifier codes '1'..'6' are the channel numbers
+	vcd_buffer[vcd_used++] = level ? '1' : '0';
+	vcd_buffer[vcd_used++] = '0' + channel;
+	vcd_buffer[vcd_used++] = '\n';
+	vcd_edges++;
+}
+
+int pwm1_vcd_open( const char* path, uint32_t pclk_hz ) {
+	if ( vcd_file ) {
+		pwm1_vcd_close();
+	}
+	vcd_file = fopen( path, "w" );
+	if ( !vcd_file || pclk_hz == 0 ) {
+		if ( vcd_file ) {
+			fclose( vcd_file );
+			vcd_file = NULL;
+		}
+		return -1;
+	}
+	vcd_pclk_hz = pclk_hz;
+	vcd_used = 0;
+	vcd_edges = 0;
+	vcd_time_written = 0;
+
+	fprintf( vcd_file, "$comment LPC1768 PWM1 model, PCLK %lu Hz $end\n", ( unsigned long )pclk_hz );
+	fprintf( vcd_file, "$timescale 1ns $end\n$scope module pwm1 $end\n" );
+	for ( int n = 1; n <= 6; n++ ) {
+		fprintf( vcd_file, "$var wire 1 %d PWM1_%d $end\n", n, n );
+	}
+	fprintf( vcd_file, "$upscope $end\n$enddefinitions $end\n" );
+	fprintf( vcd_file, "#%llu\n$dumpvars\n", ( unsigned long long )pwm1_vcd_ns( pwm1_sim_now() ) );
+	for ( int n = 1; n <= 6; n++ ) {
+		fprintf( vcd_file, "%d%d\n", pwm1_sim_output( n ), n );
+	}
+	fprintf( vcd_file, "$end\n" );
+	vcd_last_ns = pwm1_vcd_ns( pwm1_sim_now() );
+	vcd_time_written = 1;
+
+	pwm1_sim_attach_edge( &pwm1_vcd_edge );
+	return 0;
+}
+
+void pwm1_vcd_close( void ) {
+	if ( !vcd_file ) {
+		return;
+	}
+	pwm1_sim_attach_edge( NULL );
+	// mark the end of the capture so the last level has a duration
+	sprintf( vcd_buffer + vcd_used, "#%llu\n", ( unsigned long long )pwm1_vcd_ns( pwm1_sim_now() ) );
+	vcd_used += strlen( vcd_buffer + vcd_used );
+	pwm1_vcd_drain();
+	fclose( vcd_file );
+	vcd_file = NULL;
+}
+
+uint64_t pwm1_vcd_edges( void ) {
+	return vcd_edges;
+}
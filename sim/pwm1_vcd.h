@@ -0,0 +1,54 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PWM1_VCD_H
+#define PWM1_VCD_H
+
+/*
+ * Value Change Dump of the PWM1 model outputs, for GTKWave and diffing.
+ *
+ * pwm1_vcd_open() takes over the pwm1_sim edge hook and streams every
+ * edge of PWM1.1..PWM1.6 into the file through a fixed-size buffer, so
+ * the memory used does not depend on the capture length. Times are
+ * written in ns, converted from PCLK cycles with the given PCLK rate.
+ *
+ *     pwm1_vcd_open( "pwm.vcd", 24000000 );
+ *     pwm1_sim_run( 24000000 );     // one second
+ *     pwm1_vcd_close();
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Create path, write the header and the current output levels
+ *
+ *  @returns 0 on success, -1 if the file cannot be created
+ */
+int      pwm1_vcd_open ( const char* path, uint32_t pclk_hz );
+
+/** Write out the buffer, close the file and release the edge hook */
+void     pwm1_vcd_close( void );
+
+/** Edges recorded since pwm1_vcd_open() */
+uint64_t pwm1_vcd_edges( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cmsis.h"
+#include "pinmap.h"
+#include "pwm1_sim.h"
+
+LPC_PWM_TypeDef pwm1_sim_regs;
+LPC_SC_TypeDef  sc_sim_regs;
+CoreDebug_Type  core_debug_sim_regs;
+DWT_Type        dwt_sim_regs;
+
+// LPC1768 core clock with the PLL set up by the mbed startup code
+uint32_t SystemCoreClock = 96000000;
+
+static int pwm1_irq_enabled;
+// Priorities are only kept, so that tests can check what was set up
+static uint32_t irq_priority[EINT3_IRQn + 1];
+
+void NVIC_EnableIRQ( IRQn_Type irq ) {
+	if ( irq == PWM1_IRQn ) {
+		pwm1_irq_enabled = 1;
+	}
+}
+
+void NVIC_DisableIRQ( IRQn_Type irq ) {
+	if ( irq == PWM1_IRQn ) {
+		if ( pwm1_irq_enabled ) {
+			pwm1_sim_irq_flush();
+		}
+		pwm1_irq_enabled = 0;
+	}
+}
+
+void NVIC_SetPriority( IRQn_Type irq, uint32_t priority ) {
+	irq_priority[irq] = priority;
+}
+
+uint32_t NVIC_GetPriority( IRQn_Type irq ) {
+	return irq_priority[irq];
+}
+
+int pwm1_sim_irq_enabled( void ) {
+	return pwm1_irq_enabled;
+}
+
+uint32_t pinmap_peripheral( PinName pin, const PinMap* map ) {
+	if ( pin == NC ) {
+		return ( uint32_t )NC;
+	}
+	while ( map->pin != NC ) {
+		if ( map->pin == pin ) {
+			return ( uint32_t )map->peripheral;
+		}
+		map++;
+	}
+	return ( uint32_t )NC;
+}
+
+void pinmap_pinout( PinName pin, const PinMap* map ) {
+	// No pin function registers to program on the host
+	( void )pin;
+	( void )map;
+}
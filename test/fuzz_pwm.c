@@ -0,0 +1,438 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Differential fuzzing of the double edge setters. A byte stream is decoded
+ * into a sequence of set_freq, retune, set_duty_cycle, set_dephase,
+ * set_edges and write_q16 calls on three channels, interleaved with runs of
+ * the PWM1 model. The same calls drive a reference model that only knows
+ * the intended waveform: a pulse of 'width' ticks starting at 'rise' in
+ * every period. After each checked step the driver's output is compared
+ * with it tick by tick over the first periods that carry the new values,
+ * and the first divergent period is reported.
+ *
+ * Built normally this is a randomized runner over a fixed seed, part of
+ * 'make test'; an optional argument sets the number of sequences. Built
+ * with -DFUZZING it only provides LLVMFuzzerTestOneInput() ('make fuzz').
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "pwmdoubleout_api.h"
+#include "pwm1_sim.h"
+#include "test.h"
+
+#define FUZZ_CHANNELS   3
+#define FUZZ_PERIOD_MAX 100
+#define FUZZ_PERIODS    2
+#define FUZZ_OPS_MAX    64
+#define FUZZ_EDGES_MAX  ( 4 * FUZZ_CHANNELS * ( FUZZ_PERIODS + 2 ) * 2 )
+
+// PWM1.2, PWM1.4 and PWM1.6 do not share any match register
+static const PinName fuzz_pins[FUZZ_CHANNELS] = { p25, p23, p21 };
+static pwmdoubleout_t fuzz_out[FUZZ_CHANNELS];
+static int fuzz_ready;
+
+enum {
+	FUZZ_SET_FREQ,
+	FUZZ_RETUNE,
+	FUZZ_DUTY,
+	FUZZ_DEPHASE,
+	FUZZ_EDGES,
+	FUZZ_Q16,
+	FUZZ_OP_COUNT
+};
+
+static const char* const fuzz_op_names[FUZZ_OP_COUNT] = {
+	"set_freq", "retune", "set_duty_cycle", "set_dephase", "set_edges", "write_q16"
+};
+
+typedef struct {
+	uint8_t op;
+	uint8_t channel;
+	uint8_t check;
+	uint16_t gap;
+	int a;
+	int b;
+} fuzz_op_t;
+
+/*
+ * Reference model: the period and each channel's rise and width in ticks,
+ * as the setters document them, and the edges and period each channel was
+ * last set with, which retunes scale from. The period is never zero here:
+ * a stopped counter has no waveform to compare.
+ */
+typedef struct {
+	uint32_t period;
+	uint32_t rise[FUZZ_CHANNELS];
+	uint32_t width[FUZZ_CHANNELS];
+	uint32_t base_rise[FUZZ_CHANNELS];
+	uint32_t base_width[FUZZ_CHANNELS];
+	uint32_t base_period[FUZZ_CHANNELS];
+} fuzz_model_t;
+
+static fuzz_model_t model;
+
+static uint32_t model_clamp( int value ) {
+	return ( value < 0 ) ? 0 : ( uint32_t )value;
+}
+
+static void model_base( int c ) {
+	model.base_rise[c] = model.rise[c];
+	model.base_width[c] = model.width[c];
+	model.base_period[c] = model.period;
+}
+
+static void model_apply( const fuzz_op_t* op ) {
+	int c = op->channel;
+	switch ( op->op ) {
+	case FUZZ_SET_FREQ:
+		// rise and width stay in ticks, the rise folds into the period
+		model.period = model_clamp( op->a );
+		for ( int i = 0; i < FUZZ_CHANNELS; i++ ) {
+			model.rise[i] %= model.period;
+			model_base( i );
+		}
+		return;
+	case FUZZ_RETUNE:
+		// rise and width keep the fraction of the period they were last
+		// set to, rounded down once
+		model.period = model_clamp( op->a );
+		for ( int i = 0; i < FUZZ_CHANNELS; i++ ) {
+			model.rise[i]  = ( uint32_t )( ( uint64_t )model.base_rise[i] * model.period /
+			                               model.base_period[i] );
+			model.width[i] = ( uint32_t )( ( uint64_t )model.base_width[i] * model.period /
+			                               model.base_period[i] );
+		}
+		return;
+	case FUZZ_DUTY:
+		model.width[c] = model_clamp( op->a );
+		break;
+	case FUZZ_DEPHASE:
+		model.rise[c] = model_clamp( op->a ) % model.period;
+		break;
+	case FUZZ_EDGES:
+		model.rise[c] = model_clamp( op->a ) % model.period;
+		model.width[c] = model_clamp( op->b );
+		break;
+	case FUZZ_Q16: {
+		uint32_t fraction = ( uint32_t )op->a;
+		if ( fraction > PWMDOUBLEOUT_Q16_ONE ) {
+			fraction = PWMDOUBLEOUT_Q16_ONE;
+		}
+		model.width[c] = ( uint32_t )( ( ( uint64_t )model.period * fraction ) >> 16 );
+		break;
+	}
+	}
+	model_base( c );
+}
+
+/*
+ * Where channel c is set and cleared in each period: the output is set at
+ * the rise and cleared width ticks later. A zero width sets and clears at
+ * once and leaves it low, a width of a period or more never clears it. The
+ * documented exception: a pulse ending on the period boundary is cleared
+ * at 1 instead, or not at all when it rises at 1.
+ */
+static void model_edges( int c, uint32_t* rise, uint32_t* fall ) {
+	uint32_t period = model.period;
+	uint32_t width = model.width[c];
+	*rise = model.rise[c];
+	*fall = period + 1;
+	if ( width < period ) {
+		*fall = ( *rise + width ) % period;
+		if ( *rise != 0 && *fall == 0 ) {
+			*fall = ( *rise == 1 ) ? period + 1 : 1;
+		}
+	}
+}
+
+static void driver_apply( const fuzz_op_t* op ) {
+	pwmdoubleout_t* out = &fuzz_out[op->channel];
+	switch ( op->op ) {
+	case FUZZ_SET_FREQ:
+		pwmdoubleout_set_freq( NULL, op->a );
+		break;
+	case FUZZ_RETUNE:
+		pwmdoubleout_retune( NULL, op->a );
+		break;
+	case FUZZ_DUTY:
+		pwmdoubleout_set_duty_cycle( out, op->a );
+		break;
+	case FUZZ_DEPHASE:
+		pwmdoubleout_set_dephase( out, op->a );
+		break;
+	case FUZZ_EDGES:
+		pwmdoubleout_set_edges( out, op->a, op->b );
+		break;
+	case FUZZ_Q16:
+		pwmdoubleout_write_q16( out, ( uint32_t )op->a );
+		break;
+	}
+}
+
+/*
+ * Edges seen from the PWM1 model since the last check, and each channel's
+ * level before them.
+ */
+static struct {
+	uint8_t channel;
+	uint8_t level;
+	uint64_t pclk;
+} edges[FUZZ_EDGES_MAX];
+static uint32_t edge_count;
+static int edge_level[7];
+static int edge_base[7];
+
+static void edge( int channel, int level, uint64_t pclk ) {
+	edge_level[channel] = level;
+	if ( edge_count < FUZZ_EDGES_MAX ) {
+		edges[edge_count].channel = ( uint8_t )channel;
+		edges[edge_count].level = ( uint8_t )level;
+		edges[edge_count].pclk = pclk;
+	}
+	edge_count++;
+}
+
+static void edges_clear( void ) {
+	memcpy( edge_base, edge_level, sizeof( edge_base ) );
+	edge_count = 0;
+}
+
+// Run to the next period start of the active MR0, where pending values latch
+static void to_period_start( void ) {
+	uint32_t period = pwm1_sim_active( 0 );
+	uint32_t tc = LPC_PWM1->TC;
+	pwm1_sim_run( ( period > tc ) ? period - tc : 1 );
+}
+
+static const fuzz_op_t* fuzz_ops;
+static uint32_t fuzz_op_count;
+
+static void report( uint32_t step, uint32_t period, int c, uint32_t tick,
+                    int expected ) {
+	printf( "divergence after op %u, period %u, PWM1.%d tick %u: level %d, expected %d\n",
+	        step, period, fuzz_out[c].pwm, tick, !expected, expected );
+	printf( "model: period %u", model.period );
+	for ( int i = 0; i < FUZZ_CHANNELS; i++ ) {
+		printf( ", PWM1.%d rise %u width %u", fuzz_out[i].pwm, model.rise[i], model.width[i] );
+	}
+	printf( "\nsequence:\n" );
+	for ( uint32_t i = 0; i <= step && i < fuzz_op_count; i++ ) {
+		const fuzz_op_t* op = &fuzz_ops[i];
+		if ( op->op == FUZZ_SET_FREQ || op->op == FUZZ_RETUNE ) {
+			printf( "  %-14s        %d", fuzz_op_names[op->op], op->a );
+		} else if ( op->op == FUZZ_EDGES ) {
+			printf( "  %-14s PWM1.%d %d %d", fuzz_op_names[op->op],
+			        fuzz_out[op->channel].pwm, op->a, op->b );
+		} else {
+			printf( "  %-14s PWM1.%d %d", fuzz_op_names[op->op],
+			        fuzz_out[op->channel].pwm, op->a );
+		}
+		printf( ", run %u%s\n", op->gap, op->check ? ", check" : "" );
+	}
+}
+
+/*
+ * Latch whatever is pending, then compare FUZZ_PERIODS whole periods with
+ * the model. Returns zero on a divergence.
+ */
+static int check( uint32_t step ) {
+	edges_clear();
+	to_period_start();
+	uint64_t start = pwm1_sim_now();
+	uint32_t period = pwm1_sim_active( 0 );
+	if ( period != model.period ) {
+		printf( "divergence after op %u: MR0 %u, expected %u\n", step, period, model.period );
+		report( step, 0, 0, 0, 0 );
+		return 0;
+	}
+	pwm1_sim_run( ( uint64_t )period * FUZZ_PERIODS );
+	if ( edge_count > FUZZ_EDGES_MAX ) {
+		printf( "divergence after op %u: %u edges\n", step, edge_count );
+		return 0;
+	}
+	for ( int c = 0; c < FUZZ_CHANNELS; c++ ) {
+		int pwm = fuzz_out[c].pwm;
+		int level = edge_base[pwm];
+		uint32_t e = 0;
+		for ( ; e < edge_count && edges[e].pclk < start; e++ ) {
+			if ( edges[e].channel == pwm ) {
+				level = edges[e].level;
+			}
+		}
+		// the first period starts from whatever the old values left
+		int expected = level;
+		uint32_t rise;
+		uint32_t fall;
+		model_edges( c, &rise, &fall );
+		for ( uint32_t p = 0; p < FUZZ_PERIODS; p++ ) {
+			for ( uint32_t tick = 0; tick < period; tick++ ) {
+				uint64_t now = start + ( uint64_t )p * period + tick;
+				for ( ; e < edge_count && edges[e].pclk <= now; e++ ) {
+					if ( edges[e].channel == pwm ) {
+						level = edges[e].level;
+					}
+				}
+				if ( tick == fall ) {
+					expected = 0;
+				} else if ( tick == rise ) {
+					expected = 1;
+				}
+				if ( level != expected ) {
+					report( step, p, c, tick, expected );
+					return 0;
+				}
+			}
+		}
+	}
+	return 1;
+}
+
+// Decode up to FUZZ_OPS_MAX operations, each an op byte and one or two values
+static uint32_t decode( const uint8_t* data, size_t size, fuzz_op_t* ops ) {
+	uint32_t count = 0;
+	size_t i = 0;
+	while ( count < FUZZ_OPS_MAX && i + 3 <= size ) {
+		fuzz_op_t* op = &ops[count];
+		uint8_t code = data[i];
+		uint32_t raw = data[i + 1] | ( data[i + 2] << 8 );
+		i += 3;
+		op->op = code % FUZZ_OP_COUNT;
+		op->channel = ( code >> 3 ) % FUZZ_CHANNELS;
+		op->check = ( code >> 5 ) & 1;
+		op->gap = ( code >> 6 ) * 37;
+		op->b = 0;
+		// periods stay short so a check costs little; the edge arithmetic
+		// is the same at any length. Edge values run from -1 to past two
+		// periods to cover the clamping and folding.
+		uint32_t span = 2 * model.period + 2;
+		switch ( op->op ) {
+		case FUZZ_SET_FREQ:
+		case FUZZ_RETUNE:
+			op->a = 1 + ( int )( raw % FUZZ_PERIOD_MAX );
+			break;
+		case FUZZ_EDGES:
+			if ( i + 2 > size ) {
+				return count;
+			}
+			op->b = ( int )( ( data[i] | ( data[i + 1] << 8 ) ) % span ) - 1;
+			i += 2;
+			// fall through
+		case FUZZ_DUTY:
+		case FUZZ_DEPHASE:
+			op->a = ( int )( raw % span ) - 1;
+			break;
+		case FUZZ_Q16:
+			// up to twice one, to cover the clamp
+			op->a = ( int )( raw * 2 );
+			break;
+		}
+		// the model follows along so later values are relative to the
+		// period the op will see
+		model_apply( op );
+		count++;
+	}
+	return count;
+}
+
+static void fuzz_setup( void ) {
+	if ( !fuzz_ready ) {
+		pwm1_sim_reset();
+		for ( int c = 0; c < FUZZ_CHANNELS; c++ ) {
+			pwmdoubleout_init( &fuzz_out[c], fuzz_pins[c] );
+		}
+		pwm1_sim_attach_edge( edge );
+		fuzz_ready = 1;
+	}
+	// every sequence starts from the same waveform
+	model.period = 50;
+	pwmdoubleout_set_freq( NULL, model.period );
+	for ( int c = 0; c < FUZZ_CHANNELS; c++ ) {
+		model.rise[c] = 0;
+		model.width[c] = 0;
+		model_base( c );
+		pwmdoubleout_set_edges( &fuzz_out[c], 0, 0 );
+	}
+	to_period_start();
+	to_period_start();
+}
+
+// Run one sequence through the driver and the model; zero on a divergence
+static int fuzz_run( const uint8_t* data, size_t size ) {
+	static fuzz_op_t ops[FUZZ_OPS_MAX];
+	fuzz_setup();
+	fuzz_model_t start = model;
+	uint32_t count = decode( data, size, ops );
+	model = start;
+	fuzz_ops = ops;
+	fuzz_op_count = count;
+	for ( uint32_t i = 0; i < count; i++ ) {
+		model_apply( &ops[i] );
+		driver_apply( &ops[i] );
+		pwm1_sim_run( ops[i].gap );
+		if ( ( ops[i].check || i + 1 == count ) && !check( i ) ) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+#ifdef FUZZING
+
+int LLVMFuzzerTestOneInput( const uint8_t* data, size_t size ) {
+	if ( !fuzz_run( data, size ) ) {
+		abort();
+	}
+	return 0;
+}
+
+#else
+
+static uint32_t fuzz_seed = 0x2545F491;
+
+static uint32_t fuzz_random( void ) {
+	fuzz_seed ^= fuzz_seed << 13;
+	fuzz_seed ^= fuzz_seed >> 17;
+	fuzz_seed ^= fuzz_seed << 5;
+	return fuzz_seed;
+}
+
+int main( int argc, char** argv ) {
+	uint32_t sequences = ( argc > 1 ) ? ( uint32_t )strtoul( argv[1], NULL, 0 ) : 100000;
+	uint8_t data[3 * 16 + 2];
+	clock_t begin = clock();
+	for ( uint32_t n = 0; n < sequences; n++ ) {
+		size_t size = 3 + fuzz_random() % ( sizeof( data ) - 2 );
+		for ( size_t i = 0; i < size; i++ ) {
+			data[i] = ( uint8_t )fuzz_random();
+		}
+		if ( !fuzz_run( data, size ) ) {
+			printf( "sequence %u of seed 0x2545F491\n", n );
+			test_failures++;
+			break;
+		}
+	}
+	if ( argc > 1 ) {
+		double seconds = ( double )( clock() - begin ) / CLOCKS_PER_SEC;
+		printf( "%u sequences in %.2f s, %.0f per minute\n", sequences, seconds,
+		        seconds > 0 ? sequences * 60.0 / seconds : 0.0 );
+	}
+	return test_report( "fuzz_pwm" );
+}
+
+#endif
@@ -0,0 +1,73 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+/*
+ * Minimal checks for the host tests. Each test is its own program linked
+ * against the host library; it prints the failed checks and returns non
+ * zero from test_report() so 'make test' stops on it.
+ */
+
+#include <stdio.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int test_failures;
+
+#define TEST_CHECK( cond ) do { \
+		if ( !( cond ) ) { \
+			printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+			test_failures++; \
+		} \
+	} while ( 0 )
+
+#define TEST_EQUAL( actual, expected ) do { \
+		long long test_a = ( long long )( actual ); \
+		long long test_e = ( long long )( expected ); \
+		if ( test_a != test_e ) { \
+			printf( "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, \
+			        #actual, test_a, test_e ); \
+			test_failures++; \
+		} \
+	} while ( 0 )
+
+// The statement must fail an MBED_ASSERT: run in a child process, which
+// has to end on the abort() of assert
+#define TEST_ASSERTS( statement ) do { \
+		fflush( stdout ); \
+		pid_t test_pid = fork(); \
+		if ( test_pid == 0 ) { \
+			freopen( "/dev/null", "w", stderr ); \
+			statement; \
+			_exit( 0 ); \
+		} \
+		int test_status = 0; \
+		waitpid( test_pid, &test_status, 0 ); \
+		if ( !WIFSIGNALED( test_status ) || WTERMSIG( test_status ) != SIGABRT ) { \
+			printf( "%s:%d: no assert in %s\n", __FILE__, __LINE__, #statement ); \
+			test_failures++; \
+		} \
+	} while ( 0 )
+
+static inline int test_report( const char* name ) {
+	printf( "%s: %s\n", name, test_failures ? "FAILED" : "ok" );
+	return test_failures != 0;
+}
+
+#endif
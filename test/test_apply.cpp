@@ -0,0 +1,60 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * apply() of main.cpp on the host models: the dephase row wraps within the
+ * period, and stays at 0 once the period is down to FREQ_MIN, where there
+ * is nothing to wrap within. main() itself never returns, so it is
+ * renamed away as in bench_ui.
+ */
+#include "hd44780_sim.h"
+
+// before main.cpp, so the panel model sees the LCD initialisation
+static int lcd_attached = ( hd44780_sim_attach( p15, p16, p17, p18, p19, p20 ), 1 );
+
+#define main app_main
+#include "main.cpp"
+#undef main
+
+#include "test.h"
+
+int main() {
+	( void )lcd_attached;
+	WaveConfig cfg = { 100, 50, 50, 90 };
+	apply( cfg, 3, 0 );
+
+	// past the period end it wraps, below 0 it reflects
+	TEST_EQUAL( apply( cfg, 2, 20 ), 1 << 2 );
+	TEST_EQUAL( cfg.dephase, 10 );
+	TEST_EQUAL( apply( cfg, 2, -25 ), 1 << 2 );
+	TEST_EQUAL( cfg.dephase, 15 );
+
+	// the frequency row down to FREQ_MIN, then the dephase row both ways
+	TEST_EQUAL( apply( cfg, 3, -1000 ), 0x0F );
+	TEST_EQUAL( cfg.freq, FREQ_MIN );
+	TEST_EQUAL( cfg.dephase, 0 );
+	TEST_EQUAL( apply( cfg, 2, 7 ), 1 << 2 );
+	TEST_EQUAL( cfg.dephase, 0 );
+	TEST_EQUAL( apply( cfg, 2, -7 ), 1 << 2 );
+	TEST_EQUAL( cfg.dephase, 0 );
+
+	// and back to a period, where the dephase row moves again
+	apply( cfg, 3, 100 );
+	TEST_EQUAL( cfg.freq, 100 );
+	apply( cfg, 2, 30 );
+	TEST_EQUAL( cfg.dephase, 30 );
+	return test_report( "apply" );
+}
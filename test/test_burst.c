@@ -0,0 +1,197 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Bursts on the PWM1 model with the period interrupt taken late: matches
+ * coalesced into one interrupt in the middle of a burst or a gap must not
+ * change the pulse count, and one late past the last pulse is reported.
+ * Main context setters on another channel meanwhile must not take the
+ * interrupt inside their LER update.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include "pwmdoubleout_api.h"
+#include "pwm1_sim.h"
+#include "test.h"
+
+#define PERIOD 192
+#define LATE   ( PERIOD * 3 / 2 )
+
+// Pulses on PWM_2 since the last burst started, and in the bursts before
+static uint32_t pulses;
+static uint32_t done_calls;
+
+static void edge( int channel, int level, uint64_t pclk ) {
+	( void )pclk;
+	if ( channel == PWM_2 && level ) {
+		pulses++;
+	}
+}
+
+static void done( uintptr_t id ) {
+	( void )id;
+	done_calls++;
+}
+
+// Runs on from the middle of a period, so each run covers one period start
+static void to_mid_period( void ) {
+	uint32_t tc = LPC_PWM1->TC;
+	pwm1_sim_run( ( tc < PERIOD / 2 ) ? PERIOD / 2 - tc : PERIOD + PERIOD / 2 - tc );
+}
+
+// A burst of 'count' started mid period, with the interrupt of period
+// start 'late_at' (counted from 1) taken LATE ticks late
+static uint32_t burst_late( pwmdoubleout_t* a, uint32_t count, uint32_t late_at ) {
+	to_mid_period();
+	pulses = 0;
+	done_calls = 0;
+	TEST_EQUAL( pwmdoubleout_burst( a, count, 0, &done, 0 ), 0 );
+	for ( uint32_t p = 1; p <= count + 4; p++ ) {
+		pwm1_sim_irq_latency( ( p == late_at ) ? LATE : 0 );
+		pwm1_sim_run( PERIOD );
+	}
+	pwm1_sim_irq_latency( 0 );
+	TEST_CHECK( !pwmdoubleout_burst_active( a ) );
+	TEST_EQUAL( done_calls, 1 );
+	return pulses;
+}
+
+/*
+ * The interrupt at period start 1 stages the first pulse for period 2,
+ * the one at count + 1 the idle edges after the last. Late anywhere else,
+ * the burst is exact and only starts later; late at count + 1, the last
+ * pulse repeats once and that is one overrun.
+ */
+static void test_late_once( pwmdoubleout_t* a ) {
+	const uint32_t count = 10;
+	for ( uint32_t late_at = 1; late_at <= count + 1; late_at++ ) {
+		uint32_t overruns = pwmdoubleout_irq_overruns();
+		uint32_t n = burst_late( a, count, late_at );
+		TEST_EQUAL( pwmdoubleout_irq_overruns() - overruns, 1 );
+		TEST_EQUAL( n, ( late_at == count + 1 ) ? count + 1 : count );
+	}
+}
+
+/*
+ * Repeating bursts of 5 with a gap of 7, one interrupt in five late at
+ * random (a fixed pattern locks onto the burst cycle): the ones falling on
+ * a last pulse add one each, no others, and every one of them shows in the
+ * overruns.
+ */
+static void test_repeat( pwmdoubleout_t* a ) {
+	const uint32_t count = 5;
+	const uint32_t periods = 4096;
+	uint32_t overruns = pwmdoubleout_irq_overruns();
+	uint32_t bursts = 0;
+	uint32_t extra = 0;
+	uint32_t high = 0;
+	uint32_t random = 0x2545F491;
+	to_mid_period();
+	done_calls = 0;
+	TEST_EQUAL( pwmdoubleout_burst( a, count, 7, &done, 0 ), 0 );
+	pulses = 0;
+	for ( uint32_t p = 1; p <= periods; p++ ) {
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+		pwm1_sim_irq_latency( ( random % 5 == 0 ) ? LATE : 0 );
+		pwm1_sim_run( PERIOD );
+		if ( pwm1_sim_output( PWM_2 ) ) {
+			high++;
+		} else if ( high ) {
+			// the output is low mid period only between bursts
+			TEST_CHECK( high == count || high == count + 1 );
+			extra += high - count;
+			bursts++;
+			high = 0;
+		}
+	}
+	pwm1_sim_irq_latency( 0 );
+	pwmdoubleout_burst_stop( a );
+	overruns = pwmdoubleout_irq_overruns() - overruns;
+	printf( "burst 5/7 random 1 in 5: %u bursts, %u extra pulses, %u overruns\n",
+	        ( unsigned )bursts, ( unsigned )extra, ( unsigned )overruns );
+	TEST_CHECK( bursts > periods / ( count + 7 + 2 ) );
+	TEST_CHECK( done_calls >= bursts );
+	TEST_CHECK( extra > 0 );
+	TEST_CHECK( extra <= overruns );
+}
+
+// LER as the period interrupt found it
+static uint32_t ler_seen;
+static uint32_t ler_calls;
+
+static void ler_probe( uintptr_t id ) {
+	( void )id;
+	ler_seen = LPC_PWM1->LER;
+	ler_calls++;
+}
+
+/*
+ * A setter on b every period while a bursts, each with the interrupt
+ * pending. On the part it could be taken between the read and the write
+ * of LER, and the write would drop what the burst handler set there. The
+ * setter masks it for the update, so here it is taken just before (the
+ * model takes a pending interrupt as it is masked): it never sees the
+ * setter's bit, and the burst and every new width on b latch.
+ */
+static void test_ler_masked( pwmdoubleout_t* a, pwmdoubleout_t* b ) {
+	const uint32_t count = 10;
+	to_mid_period();
+	TEST_EQUAL( pwmdoubleout_irq_attach( &ler_probe, 0 ), 0 );
+	TEST_EQUAL( pwmdoubleout_burst( a, count, 0, 0, 0 ), 0 );
+	pulses = 0;
+	uint32_t fall = pwmdoubleout_match[b->pwm];
+	for ( uint32_t p = 1; p <= count + 4; p++ ) {
+		uint32_t calls = ler_calls;
+		pwm1_sim_irq_latency( PERIOD / 4 );
+		// just past the period start, the interrupt still pending
+		pwm1_sim_run( PERIOD / 2 + 8 );
+		TEST_EQUAL( pwm1_sim_active( b->pwm ), fall );
+		TEST_EQUAL( ler_calls, calls );
+		pwmdoubleout_set_duty_cycle( b, 40 + p % 2 );
+		fall = pwmdoubleout_match[b->pwm];
+		TEST_EQUAL( ler_calls, calls + 1 );
+		TEST_CHECK( !( ler_seen & ( 1 << b->pwm ) ) );
+		TEST_CHECK( LPC_PWM1->LER & ( 1 << b->pwm ) );
+		pwm1_sim_irq_latency( 0 );
+		pwm1_sim_run( PERIOD / 2 - 8 );
+	}
+	pwmdoubleout_irq_detach( &ler_probe, 0 );
+	TEST_EQUAL( pulses, count );
+	TEST_CHECK( !pwmdoubleout_burst_active( a ) );
+}
+
+int main( void ) {
+	pwmdoubleout_t a;
+	pwmdoubleout_t b;
+	pwm1_sim_reset();
+	pwmdoubleout_init( &a, p25 );
+	pwmdoubleout_init( &b, p23 );
+	pwmdoubleout_set_freq( NULL, PERIOD );
+	pwmdoubleout_set_edges( &a, 10, 96 );
+	pwm1_sim_attach_edge( edge );
+
+	TEST_EQUAL( burst_late( &a, 10, 0 ), 10 );
+	TEST_EQUAL( NVIC_GetPriority( PWM1_IRQn ), PWMDOUBLEOUT_IRQ_PRIORITY );
+	TEST_EQUAL( pwmdoubleout_irq_overruns(), 0 );
+	test_late_once( &a );
+	test_repeat( &a );
+	pwmdoubleout_set_edges( &b, 100, 40 );
+	test_ler_masked( &a, &b );
+	TEST_CHECK( !pwm1_sim_irq_enabled() );
+	return test_report( "burst" );
+}
@@ -0,0 +1,164 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * PwmComplementary: the high and low outputs are never on together and
+ * the gap between them never shrinks below the dead time, through duty
+ * sweeps, dead time changes and period changes by set_freq() and retune().
+ * Adjacent channels are refused.
+ */
+#include "PwmDoubleOut.h"
+#include "PwmComplementary.h"
+#include "pwm1_sim.h"
+#include "test.h"
+
+using namespace mbed;
+
+enum { HIGH = 2, LOW = 4 }; // PWM1.2 on p25, PWM1.4 on p23
+
+static uint32_t dead_min;     // smallest gap allowed, in ticks
+static uint64_t last_fall[7];
+static uint64_t last_rise[7];
+static uint32_t last_on;      // ticks of the last complete high pulse
+static int overlaps;
+static int short_gaps;
+
+static void edge( int channel, int level, uint64_t pclk ) {
+	if ( channel != HIGH && channel != LOW ) {
+		return;
+	}
+	uint64_t scale = ( uint64_t )LPC_PWM1->PR + 1;
+	int other = ( channel == HIGH ) ? LOW : HIGH;
+	if ( level ) {
+		last_rise[channel] = pclk;
+		if ( pwm1_sim_output( other ) ) {
+			overlaps++;
+		} else if ( last_fall[other] != 0 && pclk - last_fall[other] < dead_min * scale ) {
+			short_gaps++;
+		}
+	} else {
+		last_fall[channel] = pclk;
+		if ( channel == HIGH ) {
+			last_on = ( uint32_t )( ( pclk - last_rise[HIGH] ) / scale );
+		}
+	}
+}
+
+// Let the last change latch at the end of the running period, then run a
+// few periods on it
+static void settle() {
+	pwm1_sim_run( pwm1_sim_active( 0 ) + 4 * ( uint64_t )pwmdoubleout_match[0] );
+}
+
+static void check_clean() {
+	TEST_EQUAL( overlaps, 0 );
+	TEST_EQUAL( short_gaps, 0 );
+	overlaps = 0;
+	short_gaps = 0;
+}
+
+static void test_duty_sweep( PwmComplementary& pair ) {
+	pair.set_freq( 100 );
+	pair.set_dead_time( 3 );
+	dead_min = 3;
+	for ( int duty = 0; duty <= 110; duty += 7 ) {
+		pair.set_duty_cycle( duty );
+		settle();
+		// clamped so that both dead times fit
+		TEST_EQUAL( last_on, ( uint32_t )( duty > 94 ? 94 : duty ) );
+	}
+	check_clean();
+}
+
+// A smaller dead time applies from the period it latches in
+static void test_dead_time( PwmComplementary& pair ) {
+	pair.set_freq( 100 );
+	pair.set_duty_cycle( 40 );
+	const uint32_t dead[] = { 1, 8, 2, 20, 1, 5 };
+	for ( uint32_t k = 0; k < sizeof( dead ) / sizeof( dead[0] ); k++ ) {
+		if ( dead[k] < dead_min ) {
+			dead_min = dead[k];
+		}
+		pair.set_dead_time( dead[k] );
+		settle();
+		dead_min = dead[k];
+		TEST_EQUAL( last_on, 40 );
+	}
+	check_clean();
+}
+
+/*
+ * on 10, dead 1 at 100 ticks: a retune of the pair to 50 keeps the 20%
+ * duty and the one tick gaps, and returns to 10 of 100 from the value as
+ * set. A set_freq() keeps the on time in ticks.
+ */
+static void test_period( PwmComplementary& pair ) {
+	pair.set_freq( 100 );
+	pair.set_dead_time( 1 );
+	pair.set_duty_cycle( 10 );
+	dead_min = 1;
+	settle();
+	const int to[] = { 50, 37, 192, 61, 100 };
+	for ( uint32_t k = 0; k < sizeof( to ) / sizeof( to[0] ); k++ ) {
+		pair.retune( to[k] );
+		settle();
+		TEST_EQUAL( last_on, ( uint32_t )( 10 * to[k] / 100 ) );
+	}
+	check_clean();
+	for ( int period = 100; period >= 20; period -= 9 ) {
+		pair.set_freq( period );
+		settle();
+		TEST_EQUAL( last_on, 10 );
+	}
+	check_clean();
+}
+
+// After an output's own retune the next call on the pair derives both edges
+static void test_output_retune( PwmDoubleOut& hs, PwmComplementary& pair ) {
+	pair.set_freq( 100 );
+	pair.set_duty_cycle( 10 );
+	settle();
+	dead_min = 0;
+	hs.retune( 50 );
+	settle();
+	dead_min = 1;
+	pair.set_dead_time( 1 );
+	settle();
+	last_fall[HIGH] = last_fall[LOW] = 0;
+	short_gaps = overlaps = 0;
+	settle();
+	TEST_EQUAL( last_on, 5 );
+	check_clean();
+}
+
+static void adjacent() {
+	PwmDoubleOut hs( p25 ), ls( p24 ); // PWM1.2 and PWM1.3 share MR2
+	PwmComplementary pair( hs, ls );
+}
+
+int main() {
+	pwm1_sim_reset();
+	PwmDoubleOut hs( p25 ), ls( p23 );
+	pwm1_sim_attach_edge( edge );
+	PwmComplementary pair( hs, ls );
+
+	test_duty_sweep( pair );
+	test_dead_time( pair );
+	test_period( pair );
+	test_output_retune( hs, pair );
+	TEST_ASSERTS( adjacent() );
+	return test_report( "complementary" );
+}
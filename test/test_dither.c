@@ -0,0 +1,256 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Sigma-delta dithered edges on the PWM1 model: the average rise and width
+ * over many periods against the sub-tick target, the spectrum of the width
+ * error, and periods whose interrupt came too late to update them.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "pwmdoubleout_api.h"
+#include "cycle_probe.h"
+#include "pwm1_sim.h"
+#include "test.h"
+
+#define PERIOD  192
+#define PERIODS 2048
+#define ONE     ( 1 << PWMDOUBLEOUT_DITHER_BITS )
+
+// Rise offset and width in ticks of every pulse since pulses_clear()
+static uint32_t rise_at[PERIODS];
+static uint32_t width_of[PERIODS];
+static uint32_t pulses;
+static uint64_t origin;
+static uint64_t high_since;
+static uint32_t pclk_per_tick = 1;
+static uint32_t period_ticks = PERIOD;
+
+static void edge( int channel, int level, uint64_t pclk ) {
+	if ( channel != PWM_2 ) {
+		return;
+	}
+	if ( level ) {
+		high_since = pclk;
+	} else if ( pulses < PERIODS ) {
+		rise_at[pulses] = ( uint32_t )( ( high_since - origin ) / pclk_per_tick % period_ticks );
+		width_of[pulses] = ( uint32_t )( ( pclk - high_since ) / pclk_per_tick );
+		pulses++;
+	}
+}
+
+// Run to the next period start, where pending values latch
+static void to_period_start( void ) {
+	uint32_t period = pwm1_sim_active( 0 ) * ( LPC_PWM1->PR + 1 );
+	uint32_t pc = LPC_PWM1->TC * ( LPC_PWM1->PR + 1 ) + LPC_PWM1->PC;
+	pwm1_sim_run( ( period > pc ) ? period - pc : 1 );
+}
+
+static void pulses_clear( void ) {
+	to_period_start();
+	to_period_start();
+	origin = pwm1_sim_now();
+	pulses = 0;
+}
+
+// Largest distance of the running sum of values from count * target, in
+// 1/ONE ticks: first order sigma-delta keeps it below one tick
+static int64_t drift( const uint32_t* values, uint32_t count, uint32_t target ) {
+	int64_t sum = 0;
+	int64_t worst = 0;
+	for ( uint32_t i = 0; i < count; i++ ) {
+		sum += ( int64_t )values[i] * ONE - target;
+		if ( llabs( sum ) > worst ) {
+			worst = llabs( sum );
+		}
+	}
+	return worst;
+}
+
+// Each pulse on average where the fractional target puts it
+static void test_average( pwmdoubleout_t* a ) {
+	static const uint32_t rises[] = { 10 * ONE + ONE / 2, 3 * ONE + 1, 20 * ONE };
+	static const uint32_t widths[] = { 96 * ONE + ONE / 4, 96 * ONE + 1, 150 * ONE + 200 };
+	for ( int i = 0; i < 3; i++ ) {
+		pwmdoubleout_dither( a, rises[i], widths[i] );
+		pulses_clear();
+		pwm1_sim_run( ( uint64_t )PERIOD * ( PERIODS / 2 ) );
+		TEST_EQUAL( pulses, PERIODS / 2 );
+		TEST_CHECK( drift( rise_at, pulses, rises[i] ) < ONE );
+		TEST_CHECK( drift( width_of, pulses, widths[i] ) < ONE );
+		// every pulse one of the two ticks around the target
+		for ( uint32_t p = 0; p < pulses; p++ ) {
+			TEST_CHECK( width_of[p] - widths[i] / ONE <= 1 );
+		}
+	}
+}
+
+/*
+ * The width error is shaped away from low frequencies: with a fraction of
+ * 77/256 its power below fs/16 is a small part of the total, where a white
+ * error would have 1/8 of it there.
+ */
+static void test_spectrum( pwmdoubleout_t* a ) {
+	const uint32_t width = 96 * ONE + 77;
+	const uint32_t n = 1024;
+	pwmdoubleout_dither( a, 10 * ONE, width );
+	pulses_clear();
+	pwm1_sim_run( ( uint64_t )PERIOD * n );
+	TEST_EQUAL( pulses, n );
+	double low = 0.0;
+	double total = 0.0;
+	for ( uint32_t k = 1; k <= n / 2; k++ ) {
+		double re = 0.0;
+		double im = 0.0;
+		for ( uint32_t i = 0; i < n; i++ ) {
+			double e = ( double )width_of[i] - ( double )width / ONE;
+			re += e * cos( 2.0 * M_PI * k * i / n );
+			im -= e * sin( 2.0 * M_PI * k * i / n );
+		}
+		double power = re * re + im * im;
+		total += power;
+		if ( k < n / 16 ) {
+			low += power;
+		}
+	}
+	printf( "dither 96+77/256: error power below fs/16 %.3f%% of total\n", 100.0 * low / total );
+	TEST_CHECK( low < 0.01 * total );
+}
+
+// Periods since the previous interrupt, as each handler is told
+static uint32_t elapsed_total;
+
+static void tally( uintptr_t id ) {
+	( void )id;
+	elapsed_total += pwmdoubleout_irq_elapsed();
+}
+
+/*
+ * The interrupt of every ninth period is taken one and a half periods
+ * late, so two MR0 matches are coalesced into it and the period after
+ * repeats the last values. With half a tick to dither, eight steps apart,
+ * that is always the same carry: left alone the error would grow by half a
+ * tick each time. The periods are still all counted, and made up for.
+ */
+static void test_late( pwmdoubleout_t* a ) {
+	const uint32_t rise = 10 * ONE + ONE / 2;
+	const uint32_t width = 96 * ONE + ONE / 2;
+	TEST_EQUAL( pwmdoubleout_irq_attach( &tally, 0 ), 0 );
+	pwmdoubleout_dither( a, rise, width );
+	pulses_clear();
+	elapsed_total = 0;
+	uint32_t start = pwm1_sim_periods();
+	for ( uint32_t p = 0; p < PERIODS; p++ ) {
+		pwm1_sim_irq_latency( ( p % 9 == 0 ) ? PERIOD * 3 / 2 * pclk_per_tick : 0 );
+		pwm1_sim_run( PERIOD * pclk_per_tick );
+	}
+	pwm1_sim_irq_latency( 0 );
+	TEST_EQUAL( elapsed_total, pwm1_sim_periods() - start );
+	TEST_EQUAL( pulses, PERIODS );
+	TEST_CHECK( drift( rise_at, pulses, rise ) < 2 * ONE );
+	TEST_CHECK( drift( width_of, pulses, width ) < 2 * ONE );
+	printf( "dither late 1 in 9: drift rise %.3f width %.3f ticks\n",
+	        ( double )drift( rise_at, pulses, rise ) / ONE,
+	        ( double )drift( width_of, pulses, width ) / ONE );
+	pwmdoubleout_irq_detach( &tally, 0 );
+}
+
+// The same with the timer clocked at CCLK / 8: matches are timed in CCLK
+static void test_late_prescaled( pwmdoubleout_t* a ) {
+	pwmdoubleout_plan_t plan = { 4, 2, PERIOD, 0, 0 };
+	pwmdoubleout_apply_plan( &plan );
+	pclk_per_tick = 2;
+	test_late( a );
+	plan.pclk_div = 1;
+	plan.prescale = 1;
+	pwmdoubleout_apply_plan( &plan );
+	pclk_per_tick = 1;
+}
+
+/*
+ * Retunes while dithering: each period is counted with the MR0 it ran
+ * with, so a change of period is not a missed one. Counted with the next
+ * MR0 instead, the last 192 tick period before 64 made three, two of them
+ * overruns charged to the dither error.
+ */
+static void test_retune( pwmdoubleout_t* a ) {
+	static const uint32_t periods[] = { 64, 192, 37, 150, 192 };
+	const uint32_t rise = 10 * ONE + ONE / 2;
+	const uint32_t width = 20 * ONE + ONE / 4;
+	const uint32_t n = 1024;
+	uint32_t overruns = pwmdoubleout_irq_overruns();
+	TEST_EQUAL( pwmdoubleout_irq_attach( &tally, 0 ), 0 );
+	for ( uint32_t i = 0; i < sizeof( periods ) / sizeof( periods[0] ); i++ ) {
+		pwmdoubleout_dither( a, rise, width );
+		pwm1_sim_run( periods[i] / 3 );
+		pwmdoubleout_retune( NULL, periods[i] );
+		// the retune rescales the edges, the interrupt puts back the dither
+		pwmdoubleout_dither( a, rise, width );
+		period_ticks = periods[i];
+		elapsed_total = 0;
+		uint32_t start = pwm1_sim_periods();
+		pulses_clear();
+		pwm1_sim_run( ( uint64_t )periods[i] * n );
+		TEST_EQUAL( elapsed_total, pwm1_sim_periods() - start );
+		TEST_EQUAL( pulses, n );
+		TEST_CHECK( drift( rise_at, pulses, rise ) < ONE );
+		TEST_CHECK( drift( width_of, pulses, width ) < ONE );
+	}
+	printf( "dither across retunes: %u overruns\n",
+	        ( unsigned )( pwmdoubleout_irq_overruns() - overruns ) );
+	TEST_EQUAL( pwmdoubleout_irq_overruns(), overruns );
+	pwmdoubleout_irq_detach( &tally, 0 );
+	period_ticks = PERIOD;
+}
+
+/*
+ * cycle_probe_init() while dithering leaves the cycle counter running: the
+ * next interrupt still counts one period. Reset to 0, the count since the
+ * last period start wrapped and made millions of overruns.
+ */
+static void test_probe_init( pwmdoubleout_t* a ) {
+	uint32_t overruns = pwmdoubleout_irq_overruns();
+	TEST_EQUAL( pwmdoubleout_irq_attach( &tally, 0 ), 0 );
+	pwmdoubleout_dither( a, 10 * ONE + ONE / 2, 20 * ONE + ONE / 4 );
+	pwm1_sim_run( PERIOD * 8 + PERIOD / 2 );
+	elapsed_total = 0;
+	uint32_t start = pwm1_sim_periods();
+	cycle_probe_init();
+	pwm1_sim_run( PERIOD * 64 );
+	TEST_EQUAL( elapsed_total, pwm1_sim_periods() - start );
+	TEST_EQUAL( pwmdoubleout_irq_overruns(), overruns );
+	pwmdoubleout_irq_detach( &tally, 0 );
+}
+
+int main( void ) {
+	pwmdoubleout_t a;
+	pwm1_sim_reset();
+	pwmdoubleout_init( &a, p25 );
+	pwmdoubleout_set_freq( NULL, PERIOD );
+	pwm1_sim_attach_edge( edge );
+	pulses_clear();
+
+	test_average( &a );
+	test_spectrum( &a );
+	test_late( &a );
+	test_late_prescaled( &a );
+	test_retune( &a );
+	test_probe_init( &a );
+	pwmdoubleout_dither_stop( &a );
+	TEST_CHECK( !pwm1_sim_irq_enabled() );
+	return test_report( "dither" );
+}
@@ -0,0 +1,90 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * The TextLCD integer formatters against the C library printf they
+ * replaced: printInt() against "%0*u", printTenths() against "%0*.1f" of
+ * the percentage and printKhz() against the integer division, compared
+ * through the panel's display RAM.
+ */
+#include "TextLCD.h"
+#include "hd44780_sim.h"
+#include "test.h"
+
+static TextLCD* lcd;
+
+// Run one formatter at the start of row 0 and return what the panel shows
+static const char* shown( int length ) {
+	static char text[21];
+	lcd->flush();
+	hd44780_sim_read( 0x00, text, length );
+	return text;
+}
+
+static void expect( const char* actual, const char* expected, const char* what, uint32_t a, uint32_t b ) {
+	if ( strcmp( actual, expected ) != 0 ) {
+		printf( "%s( %u, %u ) shows \"%s\", printf gives \"%s\"\n", what,
+		        ( unsigned )a, ( unsigned )b, actual, expected );
+		test_failures++;
+	}
+}
+
+int main() {
+	hd44780_sim_attach( p15, p16, p17, p18, p19, p20 );
+	TextLCD panel( p15, p16, p17, p18, p19, p20, TextLCD::LCD20x4 );
+	lcd = &panel;
+	char expected[24];
+
+	static const uint32_t VALUES[] = { 0, 1, 9, 10, 99, 12345, 99999, 100000, 4294967295u };
+	for ( uint32_t i = 0; i < sizeof( VALUES ) / sizeof( VALUES[0] ); i++ ) {
+		for ( int width = 1; width <= 5; width++ ) {
+			int n = snprintf( expected, sizeof( expected ), "%0*u", width, ( unsigned )VALUES[i] );
+			panel.locate( 0, 0 );
+			panel.printString( "          " );
+			panel.locate( 0, 0 );
+			panel.printInt( VALUES[i], width );
+			expect( shown( n ), expected, "printInt", VALUES[i], width );
+		}
+	}
+
+	// every duty cycle of the periods the front panel uses
+	static const uint32_t PERIODS[] = { 1, 3, 7, 192, 1000, 3000 };
+	for ( uint32_t p = 0; p < sizeof( PERIODS ) / sizeof( PERIODS[0] ); p++ ) {
+		uint32_t den = PERIODS[p];
+		for ( uint32_t num = 0; num <= den; num++ ) {
+			int n = snprintf( expected, sizeof( expected ), "%04.1f", 100.0 * num / den );
+			panel.locate( 0, 0 );
+			panel.printTenths( num, den, 4 );
+			expect( shown( n ), expected, "printTenths", num, den );
+		}
+	}
+	panel.locate( 0, 0 );
+	panel.printTenths( 5, 0, 4 );
+	expect( shown( 4 ), "----", "printTenths", 5, 0 );
+
+	for ( uint32_t ticks = 1; ticks <= 3000; ticks++ ) {
+		int n = snprintf( expected, sizeof( expected ), "%04u", ( unsigned )( 96000 / ticks ) );
+		panel.locate( 0, 0 );
+		panel.printString( "     " );
+		panel.locate( 0, 0 );
+		panel.printKhz( ticks, 96000, 4 );
+		expect( shown( n ), expected, "printKhz", ticks, 96000 );
+	}
+	panel.locate( 0, 0 );
+	panel.printKhz( 0, 96000, 4 );
+	expect( shown( 4 ), "----", "printKhz", 0, 96000 );
+
+	return test_report( "format" );
+}
@@ -0,0 +1,128 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * PwmInterleaved: channel k rises at k * period / phases and every channel
+ * is high for the common duty cycle, measured on the outputs through duty
+ * cycle, frequency and phase count changes. Adjacent channels are refused.
+ */
+#include "PwmDoubleOut.h"
+#include "PwmInterleaved.h"
+#include "pwm1_sim.h"
+#include "test.h"
+
+using namespace mbed;
+
+static const int channel[3] = { 2, 4, 6 }; // p25, p23, p21
+
+// Run to the next period start, then the rise offset and high time in
+// ticks of channel 'pwm' over one period
+static void measure( int pwm, uint32_t* rise, uint32_t* high ) {
+	uint32_t periods = pwm1_sim_periods();
+	int last = 0;
+	while ( pwm1_sim_periods() == periods ) {
+		// the level just before the period start, to see a rise at 0
+		last = pwm1_sim_output( pwm );
+		pwm1_sim_run( 1 );
+	}
+	*rise = UINT32_MAX;
+	*high = 0;
+	for ( uint32_t t = 0; t < pwm1_sim_active( 0 ); t++ ) {
+		int level = pwm1_sim_output( pwm );
+		if ( level && !last ) {
+			*rise = t;
+		}
+		*high += level;
+		last = level;
+		pwm1_sim_run( 1 );
+	}
+}
+
+// Each of 'count' channels rises k * period / phases into the period and
+// stays high for 'width' ticks, one more when the driver moves a fall on
+// the period start to tick 1
+static void check_spacing( int count, int phases, uint32_t width ) {
+	for ( int k = 0; k < count; k++ ) {
+		uint32_t rise, high;
+		measure( channel[k], &rise, &high );
+		uint32_t period = pwm1_sim_active( 0 );
+		TEST_EQUAL( rise, k * period / phases );
+		TEST_EQUAL( high, width + ( ( k * period / phases + width ) % period == 0 ) );
+	}
+}
+
+static void test_duty( PwmInterleaved& buck ) {
+	buck.set_freq( 192 );
+	for ( int width = 1; width < 192; width += 7 ) {
+		buck.set_duty_cycle( width );
+		check_spacing( 3, 3, width );
+	}
+}
+
+// The duty ratio and the spacing follow the period
+static void test_freq( PwmInterleaved& buck ) {
+	const int periods[] = { 192, 100, 97, 250, 64, 1000 };
+	buck.write_q16( PWMDOUBLEOUT_Q16_ONE / 4 );
+	for ( unsigned i = 0; i < sizeof( periods ) / sizeof( periods[0] ); i++ ) {
+		buck.set_freq( periods[i] );
+		check_spacing( 3, 3, periods[i] / 4 );
+	}
+	// set at one period, scaled to the next
+	buck.set_duty_cycle( 300 );
+	buck.set_freq( 100 );
+	check_spacing( 3, 3, 30 );
+}
+
+// Fewer channels than phases sit 360 / phases degrees apart
+static void test_phases( PwmInterleaved& buck, PwmInterleaved& pair ) {
+	buck.set_freq( 210 );
+	buck.set_duty_cycle( 40 );
+	for ( int phases = 3; phases <= 7; phases++ ) {
+		buck.set_phases( phases );
+		check_spacing( 3, phases, 40 );
+	}
+	pair.set_duty_cycle( 70 );
+	for ( int phases = 2; phases <= 7; phases++ ) {
+		pair.set_phases( phases );
+		check_spacing( 2, phases, 70 );
+	}
+}
+
+static void adjacent_pair() {
+	PwmDoubleOut a( p25 ), b( p24 ); // PWM1.2 and PWM1.3 share MR2
+	PwmInterleaved pair( a, b );
+}
+
+static void adjacent_last() {
+	PwmDoubleOut a( p25 ), b( p23 ), c( p22 ); // PWM1.4 and PWM1.5 share MR4
+	PwmInterleaved buck( a, b, c );
+}
+
+int main() {
+	pwm1_sim_reset();
+	PwmDoubleOut a( p25 ), b( p23 ), c( p21 );
+	PwmInterleaved buck( a, b, c );
+
+	test_duty( buck );
+	test_freq( buck );
+	{
+		PwmInterleaved pair( a, b );
+		test_phases( buck, pair );
+	}
+	TEST_ASSERTS( adjacent_pair() );
+	TEST_ASSERTS( adjacent_last() );
+	return test_report( "interleaved" );
+}
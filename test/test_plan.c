@@ -0,0 +1,151 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * pwmdoubleout_plan(): divider, prescale and MR0 for a frequency, the
+ * achieved frequency and its error, and the settings it refuses.
+ * pwmdoubleout_apply_plan(): the clock and period switched together with
+ * every channel's duty cycle and dephase kept, measured on the outputs.
+ */
+#include <stdint.h>
+#include "pwmdoubleout_api.h"
+#include "pwm1_sim.h"
+#include "test.h"
+
+static void test_choice( void ) {
+	pwmdoubleout_plan_t plan;
+	// 96 MHz / 20 kHz is exact at /1, /2, /4 and /8: the finest MR0 wins
+	TEST_EQUAL( pwmdoubleout_plan( &plan, 20000, 1000 ), 0 );
+	TEST_EQUAL( plan.pclk_div, 1 );
+	TEST_EQUAL( plan.prescale, 1 );
+	TEST_EQUAL( plan.period, 4800 );
+	TEST_EQUAL( plan.freq_hz, 20000 );
+	TEST_EQUAL( plan.error_ppm, 0 );
+	TEST_EQUAL( pwmdoubleout_plan( &plan, 1000000, 64 ), 0 );
+	TEST_EQUAL( plan.period, 96 );
+	TEST_EQUAL( plan.error_ppm, 0 );
+	TEST_EQUAL( pwmdoubleout_plan( &plan, 1, 1 ), 0 );
+	TEST_EQUAL( plan.period, 96000000 );
+	TEST_EQUAL( plan.freq_hz, 1 );
+}
+
+// MR0 rounds to nearest, the error is signed and truncated to whole ppm
+static void test_error( void ) {
+	pwmdoubleout_plan_t plan;
+	// 13714.29 ticks -> 13714: 7000.146 Hz
+	TEST_EQUAL( pwmdoubleout_plan( &plan, 7000, 1000 ), 0 );
+	TEST_EQUAL( plan.period, 13714 );
+	TEST_EQUAL( plan.freq_hz, 7000 );
+	TEST_EQUAL( plan.error_ppm, 20 );
+	// 777.6 ticks -> 778: 123393.3 Hz
+	TEST_EQUAL( pwmdoubleout_plan( &plan, 123457, 100 ), 0 );
+	TEST_EQUAL( plan.period, 778 );
+	TEST_EQUAL( plan.freq_hz, 123393 );
+	TEST_EQUAL( plan.error_ppm, -515 );
+}
+
+static void test_unreachable( void ) {
+	pwmdoubleout_plan_t plan = { 0, 0, 0, 0, 0 };
+	TEST_EQUAL( pwmdoubleout_plan( &plan, 0, 100 ), -1 );
+	// 4800 ticks is the most 20 kHz gets, at /1 without prescale
+	TEST_EQUAL( pwmdoubleout_plan( &plan, 20000, 4800 ), 0 );
+	TEST_EQUAL( pwmdoubleout_plan( &plan, 20000, 4801 ), -1 );
+	TEST_EQUAL( pwmdoubleout_plan( &plan, 48000000, 3 ), -1 );
+}
+
+// Run to the next period start, then the rise offset and high time in
+// ticks of channel 'pwm' over one period
+static void measure( int pwm, uint32_t* rise, uint32_t* high ) {
+	uint32_t scale = LPC_PWM1->PR + 1;
+	uint32_t periods = pwm1_sim_periods();
+	while ( pwm1_sim_periods() == periods ) {
+		pwm1_sim_run( 1 );
+	}
+	uint32_t pclk = pwm1_sim_active( 0 ) * scale;
+	uint32_t first = pclk;
+	uint32_t count = 0;
+	for ( uint32_t t = 0; t < pclk; t++ ) {
+		if ( pwm1_sim_output( pwm ) ) {
+			if ( first == pclk ) {
+				first = t;
+			}
+			count++;
+		}
+		pwm1_sim_run( 1 );
+	}
+	*rise = first / scale;
+	*high = count / scale;
+}
+
+// The sim only sees the TCR value left between runs, so it takes the
+// restart of apply_plan as a latch at the next period start
+static void check_outputs( uint32_t period ) {
+	uint32_t rise, high;
+	measure( 2, &rise, &high );
+	TEST_EQUAL( pwm1_sim_active( 0 ), period );
+	TEST_EQUAL( rise, period / 4 );
+	TEST_EQUAL( high, period / 2 );
+	measure( 4, &rise, &high );
+	TEST_EQUAL( rise, period * 100 / 192 );
+	TEST_EQUAL( high, period * 130 / 192 - period * 100 / 192 );
+}
+
+/*
+ * a: 48 + 96 of 192, b: 100 + 30 of 192, through 20 kHz at /1, then 192
+ * ticks at /4 with PR = 1, and back to 4800 at /1: each period holds the
+ * same fractions, and the way back lands on the values as set.
+ */
+static void test_apply( pwmdoubleout_t* a, pwmdoubleout_t* b ) {
+	pwmdoubleout_set_freq( NULL, 192 );
+	pwmdoubleout_set_edges( a, 48, 96 );
+	pwmdoubleout_set_edges( b, 100, 30 );
+	pwm1_sim_run( 3 * 192 );
+
+	pwmdoubleout_plan_t plan;
+	TEST_EQUAL( pwmdoubleout_plan( &plan, 20000, 1000 ), 0 );
+	pwmdoubleout_apply_plan( &plan );
+	TEST_EQUAL( ( LPC_SC->PCLKSEL0 >> 12 ) & 0x3, 1 );
+	TEST_EQUAL( LPC_PWM1->PR, 0 );
+	TEST_EQUAL( pwmdoubleout_clock_hz(), 96000000 );
+	check_outputs( 4800 );
+
+	pwmdoubleout_plan_t slow = { 4, 2, 192, 0, 0 };
+	pwmdoubleout_apply_plan( &slow );
+	TEST_EQUAL( ( LPC_SC->PCLKSEL0 >> 12 ) & 0x3, 0 );
+	TEST_EQUAL( LPC_PWM1->PR, 1 );
+	TEST_EQUAL( pwmdoubleout_clock_hz(), 12000000 );
+	check_outputs( 192 );
+	TEST_EQUAL( pwm1_sim_active( 1 ), 48 );
+	TEST_EQUAL( pwm1_sim_active( 2 ), 144 );
+	TEST_EQUAL( pwm1_sim_active( 3 ), 100 );
+	TEST_EQUAL( pwm1_sim_active( 4 ), 130 );
+
+	pwmdoubleout_apply_plan( &plan );
+	check_outputs( 4800 );
+}
+
+int main( void ) {
+	pwmdoubleout_t a, b;
+	pwm1_sim_reset();
+	pwmdoubleout_init( &a, p25 ); // PWM1.2: rises on MR1, falls on MR2
+	pwmdoubleout_init( &b, p23 ); // PWM1.4: rises on MR3, falls on MR4
+
+	test_choice();
+	test_error();
+	test_unreachable();
+	test_apply( &a, &b );
+	return test_report( "plan" );
+}
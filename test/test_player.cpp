@@ -0,0 +1,62 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * PwmDoublePlayer: the three phases follow the table one entry per period,
+ * 120 degrees apart, also while the main context holds a PwmDoubleGroup
+ * open across the whole run.
+ */
+#include "PwmDoubleOut.h"
+#include "PwmDoubleGroup.h"
+#include "PwmDoublePlayer.h"
+#include "PwmDoubleTables.h"
+#include "pwm1_sim.h"
+#include "test.h"
+
+using namespace mbed;
+
+typedef SpwmTable<12, 60, 800> Table;
+
+int main() {
+	pwm1_sim_reset();
+	PwmDoubleOut a( p25 ), b( p23 ), c( p21 ); // PWM1.2, PWM1.4, PWM1.6
+	a.set_freq( 60 );
+	a.set_edges( 0, 1 );
+	b.set_edges( 0, 1 );
+	c.set_edges( 0, 1 );
+	pwm1_sim_run( 600 );
+
+	PwmDoublePlayer player( a, b, c, Table::duty, Table::size );
+	// run to just past a period start
+	pwm1_sim_run( 60 - LPC_PWM1->TC + 1 );
+	{
+		PwmDoubleGroup group;
+		TEST_EQUAL( player.start(), 0 );
+		// entry k is stored by the interrupt at the start of period k + 1
+		// and latched at the start of period k + 2
+		pwm1_sim_run( 60 );
+		for ( uint32_t k = 0; k < 2 * Table::size; k++ ) {
+			pwm1_sim_run( 60 );
+			uint32_t i = k % Table::size;
+			TEST_EQUAL( pwm1_sim_active( 2 ), Table::duty[i] );
+			TEST_EQUAL( pwm1_sim_active( 4 ), Table::duty[( i + 8 ) % 12] );
+			TEST_EQUAL( pwm1_sim_active( 6 ), Table::duty[( i + 4 ) % 12] );
+		}
+		TEST_EQUAL( pwmdoubleout_group_mask, 0 );
+	}
+	player.stop();
+	TEST_CHECK( !pwm1_sim_irq_enabled() );
+	return test_report( "player" );
+}
@@ -0,0 +1,196 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * The PWM1 model and the double edge driver on top of it: counter reset on
+ * MR0, LER latching at the period start, double edge set/clear, and the
+ * waveforms the setters produce for every rise and width of a short period.
+ */
+#include "pwmdoubleout_api.h"
+#include "pwm1_sim.h"
+#include "test.h"
+
+static uint64_t high[7];
+static uint64_t high_since[7];
+static uint32_t rises[7];
+
+static void edge( int channel, int level, uint64_t pclk ) {
+	if ( level ) {
+		rises[channel]++;
+		high_since[channel] = pclk;
+	} else {
+		high[channel] += pclk - high_since[channel];
+	}
+}
+
+// Run to the next period start of the active MR0
+static void to_period_start( void ) {
+	uint32_t period = pwm1_sim_active( 0 );
+	uint32_t tc = LPC_PWM1->TC;
+	pwm1_sim_run( ( period > tc ) ? period - tc : 1 );
+}
+
+// Let pending match values latch, then stop on a period start
+static void settle( void ) {
+	to_period_start();
+	to_period_start();
+}
+
+// Measure one channel over 'periods' whole periods
+static void measure( int channel, uint32_t periods ) {
+	high[channel] = 0;
+	rises[channel] = 0;
+	if ( pwm1_sim_output( channel ) ) {
+		high_since[channel] = pwm1_sim_now();
+	}
+	pwm1_sim_run( ( uint64_t )pwm1_sim_active( 0 ) * periods );
+	if ( pwm1_sim_output( channel ) ) {
+		high[channel] += pwm1_sim_now() - high_since[channel];
+		high_since[channel] = pwm1_sim_now();
+	}
+}
+
+static void test_counter( void ) {
+	pwmdoubleout_set_freq( NULL, 100 );
+	settle();
+	TEST_EQUAL( pwm1_sim_active( 0 ), 100 );
+	TEST_EQUAL( LPC_PWM1->TC, 0 );
+	uint32_t start = pwm1_sim_periods();
+	pwm1_sim_run( 1000 );
+	TEST_EQUAL( pwm1_sim_periods() - start, 10 );
+	pwm1_sim_run( 37 );
+	TEST_EQUAL( LPC_PWM1->TC, 37 );
+}
+
+static void test_latch( pwmdoubleout_t* a ) {
+	pwmdoubleout_set_edges( a, 10, 20 );
+	settle();
+	// a store without its LER bit never reaches the comparator
+	LPC_PWM1->MR2 = 50;
+	to_period_start();
+	TEST_EQUAL( pwm1_sim_active( 2 ), 30 );
+	// with it, the value is taken at the next period start only
+	LPC_PWM1->LER |= 1 << 2;
+	pwm1_sim_run( 5 );
+	TEST_EQUAL( pwm1_sim_active( 2 ), 30 );
+	to_period_start();
+	TEST_EQUAL( pwm1_sim_active( 2 ), 50 );
+	measure( a->pwm, 1 );
+	TEST_EQUAL( high[a->pwm], 40 );
+	pwmdoubleout_set_edges( a, 10, 20 );
+	settle();
+}
+
+// Every rise and width of a short period, through each setter
+static void test_waveforms( pwmdoubleout_t* a ) {
+	const uint32_t period = 16;
+	pwmdoubleout_set_freq( NULL, period );
+	for ( uint32_t rise = 0; rise < period; rise++ ) {
+		for ( uint32_t width = 0; width <= period; width++ ) {
+			pwmdoubleout_set_dephase( a, rise );
+			pwmdoubleout_set_duty_cycle( a, width );
+			settle();
+			measure( a->pwm, 4 );
+			uint32_t expected = width;
+			if ( rise != 0 && rise + width == period ) {
+				// a fall at 0 is moved to 1, or out of range when the
+				// rise is at 1: the pulse is one tick longer
+				expected = ( rise == 1 ) ? period : width + 1;
+			}
+			if ( high[a->pwm] != 4 * expected ) {
+				printf( "rise %u width %u: high %llu\n", rise, width,
+				        ( unsigned long long )high[a->pwm] );
+			}
+			TEST_EQUAL( high[a->pwm], 4 * expected );
+			if ( width > 0 && expected < period ) {
+				TEST_EQUAL( rises[a->pwm], 4 );
+			}
+		}
+	}
+}
+
+// A retune keeps the counter running: no period is cut short
+static void test_retune( pwmdoubleout_t* a, pwmdoubleout_t* b ) {
+	pwmdoubleout_set_freq( NULL, 200 );
+	pwmdoubleout_set_edges( a, 0, 100 );
+	pwmdoubleout_set_edges( b, 50, 50 );
+	settle();
+	pwm1_sim_run( 120 );
+	uint32_t start = pwm1_sim_periods();
+	pwmdoubleout_retune( NULL, 100 );
+	// the running period still ends at 200
+	pwm1_sim_run( 79 );
+	TEST_EQUAL( pwm1_sim_periods(), start );
+	TEST_EQUAL( pwm1_sim_active( 0 ), 200 );
+	pwm1_sim_run( 1 );
+	TEST_EQUAL( pwm1_sim_periods(), start + 1 );
+	TEST_EQUAL( pwm1_sim_active( 0 ), 100 );
+	measure( a->pwm, 3 );
+	TEST_EQUAL( high[a->pwm], 3 * 50 );
+	measure( b->pwm, 3 );
+	TEST_EQUAL( high[b->pwm], 3 * 25 );
+	TEST_EQUAL( pwm1_sim_active( b->pwm - 1 ), 25 );
+}
+
+/*
+ * Retunes one tick at a time, 192 up to 384 and back: each one scales from
+ * the edges as set, so the duty cycle and dephase hold all the way and the
+ * edges come back to the same ticks. Rounding the rounded edges again
+ * every step left the width at 96 of 384, and at 0 on the way back.
+ */
+static void test_retune_series( pwmdoubleout_t* a, pwmdoubleout_t* b ) {
+	pwmdoubleout_set_freq( NULL, 192 );
+	pwmdoubleout_set_edges( a, 48, 96 );
+	pwmdoubleout_set_edges( b, 100, 17 );
+	for ( int ticks = 193; ticks <= 384; ticks++ ) {
+		pwmdoubleout_retune( NULL, ticks );
+		TEST_EQUAL( pwmdoubleout_width[a->pwm], ( uint32_t )ticks / 2 );
+		TEST_EQUAL( pwmdoubleout_match[a->pwm - 1], ( uint32_t )ticks / 4 );
+	}
+	settle();
+	measure( a->pwm, 2 );
+	TEST_EQUAL( high[a->pwm], 2 * 192 );
+	for ( int ticks = 383; ticks >= 192; ticks-- ) {
+		pwmdoubleout_retune( NULL, ticks );
+	}
+	TEST_EQUAL( pwmdoubleout_match[a->pwm - 1], 48 );
+	TEST_EQUAL( pwmdoubleout_width[a->pwm], 96 );
+	TEST_EQUAL( pwmdoubleout_match[b->pwm - 1], 100 );
+	TEST_EQUAL( pwmdoubleout_width[b->pwm], 17 );
+	// a setter starts the next series from its own edges
+	pwmdoubleout_set_duty_cycle( a, 50 );
+	pwmdoubleout_retune( NULL, 96 );
+	TEST_EQUAL( pwmdoubleout_width[a->pwm], 25 );
+	TEST_EQUAL( pwmdoubleout_match[a->pwm - 1], 24 );
+	settle();
+	measure( a->pwm, 2 );
+	TEST_EQUAL( high[a->pwm], 2 * 25 );
+}
+
+int main( void ) {
+	pwmdoubleout_t a;
+	pwmdoubleout_t b;
+	pwm1_sim_reset();
+	pwmdoubleout_init( &a, p25 );
+	pwmdoubleout_init( &b, p23 );
+	pwm1_sim_attach_edge( edge );
+
+	test_counter();
+	test_latch( &a );
+	test_waveforms( &a );
+	test_retune( &a, &b );
+	test_retune_series( &a, &b );
+	return test_report( "pwm1_sim" );
+}
@@ -0,0 +1,65 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * Q16 duty and dephase: the match values written by the integer setters,
+ * read_q16() across the whole MR0 range, and agreement with the float path.
+ */
+#include "pwmdoubleout_api.h"
+#include "pwm1_sim.h"
+#include "test.h"
+
+static void test_period( pwmdoubleout_t* a, uint32_t period ) {
+	pwmdoubleout_set_freq( NULL, period );
+	for ( uint32_t fraction = 0; fraction <= PWMDOUBLEOUT_Q16_ONE; fraction += 0x0800 ) {
+		uint32_t ticks = ( uint32_t )( ( ( uint64_t )period * fraction ) >> 16 );
+		pwmdoubleout_dephase_q16( a, 0 );
+		pwmdoubleout_write_q16( a, fraction );
+		TEST_EQUAL( pwmdoubleout_width[a->pwm], ticks );
+		// read back within one tick of the value written
+		uint32_t back = pwmdoubleout_read_q16( a );
+		uint32_t tick_q16 = ( uint32_t )( ( 0x10000ull + period - 1 ) / period );
+		TEST_CHECK( back <= fraction && fraction - back <= tick_q16 );
+		// the float path lands on the same tick, while MR0 fits a float
+		if ( period < ( 1u << 24 ) ) {
+			pwmdoubleout_write( a, fraction / 65536.0f );
+			int32_t diff = ( int32_t )pwmdoubleout_width[a->pwm] - ( int32_t )ticks;
+			TEST_CHECK( diff >= -1 && diff <= 1 );
+		}
+
+		pwmdoubleout_dephase_q16( a, fraction );
+		uint32_t rise = ( ticks >= period ) ? 0 : ticks;
+		TEST_EQUAL( pwmdoubleout_match[a->pwm - 1], rise );
+	}
+	// out of range fractions saturate
+	pwmdoubleout_write_q16( a, PWMDOUBLEOUT_Q16_ONE + 1 );
+	TEST_EQUAL( pwmdoubleout_read_q16( a ), PWMDOUBLEOUT_Q16_ONE );
+	pwmdoubleout_write( a, 1.0f );
+	TEST_EQUAL( pwmdoubleout_read_q16( a ), PWMDOUBLEOUT_Q16_ONE );
+}
+
+int main( void ) {
+	pwmdoubleout_t a;
+	pwm1_sim_reset();
+	pwmdoubleout_init( &a, p25 );
+
+	test_period( &a, 192 );
+	test_period( &a, 65535 );
+	test_period( &a, 65537 );
+	// the 20 ms default at 96 MHz, where width << 16 needs 64 bits
+	test_period( &a, 1920000 );
+	test_period( &a, 0x7fffffff );
+	return test_report( "q16" );
+}
@@ -0,0 +1,152 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * QuadratureDecoder against A/B traces in the form a logic analyzer
+ * exports them: one record per level change of either line, with its
+ * timestamp. Each trace is replayed edge by edge and the steps returned
+ * are summed, as the encoder interrupt in main.cpp does.
+ */
+#include "QuadratureDecoder.h"
+#include "test.h"
+
+struct Sample {
+	uint32_t us;
+	uint8_t a;
+	uint8_t b;
+};
+
+struct Replay {
+	int32_t steps;
+	uint32_t detents;
+	int32_t last;
+};
+
+// Replay a trace from its first record, which gives the idle levels
+static Replay replay( QuadratureDecoder& decoder, const Sample* trace, uint32_t count ) {
+	Replay r = { 0, 0, 0 };
+	decoder.reset( trace[0].a, trace[0].b );
+	for ( uint32_t i = 1; i < count; i++ ) {
+		int32_t steps = decoder.edge( trace[i].a, trace[i].b, trace[i].us );
+		if ( steps != 0 ) {
+			r.steps += steps;
+			r.detents++;
+			r.last = steps;
+		}
+	}
+	return r;
+}
+
+#define COUNT( trace ) ( sizeof( trace ) / sizeof( trace[0] ) )
+
+// Three slow detents clockwise, 200 ms apart; idle with both lines high
+static const Sample CLEAN_CW[] = {
+	{ 0, 1, 1 },
+	{ 1000, 1, 0 }, { 4000, 0, 0 }, { 7000, 0, 1 }, { 10000, 1, 1 },
+	{ 201000, 1, 0 }, { 204000, 0, 0 }, { 207000, 0, 1 }, { 210000, 1, 1 },
+	{ 401000, 1, 0 }, { 404000, 0, 0 }, { 407000, 0, 1 }, { 410000, 1, 1 },
+};
+
+// Two slow detents counter-clockwise
+static const Sample CLEAN_CCW[] = {
+	{ 0, 1, 1 },
+	{ 1000, 0, 1 }, { 4000, 0, 0 }, { 7000, 1, 0 }, { 10000, 1, 1 },
+	{ 301000, 0, 1 }, { 304000, 0, 0 }, { 307000, 1, 0 }, { 310000, 1, 1 },
+};
+
+// One clockwise detent with contact bounce on every transition: each line
+// chatters for a few hundred us before it settles
+static const Sample BOUNCE_CW[] = {
+	{ 0, 1, 1 },
+	{ 1000, 1, 0 }, { 1040, 1, 1 }, { 1090, 1, 0 }, { 1200, 1, 1 }, { 1350, 1, 0 },
+	{ 4000, 0, 0 }, { 4030, 1, 0 }, { 4070, 0, 0 },
+	{ 7000, 0, 1 }, { 7020, 0, 0 }, { 7100, 0, 1 }, { 7110, 0, 0 }, { 7300, 0, 1 },
+	{ 10000, 1, 1 }, { 10050, 0, 1 }, { 10090, 1, 1 },
+};
+
+// Bounce at the detent position itself: the last transition of the
+// detent is crossed back and forth, which must not count twice
+static const Sample BOUNCE_AT_DETENT[] = {
+	{ 0, 1, 1 },
+	{ 1000, 1, 0 }, { 4000, 0, 0 }, { 7000, 0, 1 },
+	{ 10000, 1, 1 }, { 10040, 0, 1 }, { 10080, 1, 1 }, { 10150, 0, 1 }, { 10200, 1, 1 },
+};
+
+// A sampled capture that missed the 00 state: 10 -> 01 changes both
+// lines at once. The skipped transition is rejected, the detent after it
+// is only completed by the next quarter steps.
+static const Sample SKIPPED_CW[] = {
+	{ 0, 1, 1 },
+	{ 1000, 1, 0 }, { 7000, 0, 1 }, { 10000, 1, 1 },
+	{ 201000, 1, 0 }, { 204000, 0, 0 }, { 207000, 0, 1 }, { 210000, 1, 1 },
+	{ 401000, 1, 0 }, { 404000, 0, 0 }, { 407000, 0, 1 }, { 410000, 1, 1 },
+};
+
+// A quick spin: detents 10 ms apart, then one the other way
+static const Sample SPIN_CW[] = {
+	{ 0, 1, 1 },
+	{ 100000, 1, 0 }, { 101000, 0, 0 }, { 102000, 0, 1 }, { 103000, 1, 1 },
+	{ 110000, 1, 0 }, { 111000, 0, 0 }, { 112000, 0, 1 }, { 113000, 1, 1 },
+	{ 120000, 1, 0 }, { 121000, 0, 0 }, { 122000, 0, 1 }, { 123000, 1, 1 },
+	{ 125000, 0, 1 }, { 126000, 0, 0 }, { 127000, 1, 0 }, { 128000, 1, 1 },
+};
+
+int main() {
+	QuadratureDecoder decoder;
+	Replay r;
+
+	r = replay( decoder, CLEAN_CW, COUNT( CLEAN_CW ) );
+	TEST_EQUAL( r.steps, 3 );
+	TEST_EQUAL( r.detents, 3 );
+	TEST_EQUAL( decoder.position(), 12 );
+	TEST_EQUAL( decoder.errors(), 0 );
+
+	r = replay( decoder, CLEAN_CCW, COUNT( CLEAN_CCW ) );
+	TEST_EQUAL( r.steps, -2 );
+	TEST_EQUAL( decoder.position(), -8 );
+	TEST_EQUAL( decoder.errors(), 0 );
+
+	r = replay( decoder, BOUNCE_CW, COUNT( BOUNCE_CW ) );
+	TEST_EQUAL( r.steps, 1 );
+	TEST_EQUAL( r.detents, 1 );
+	TEST_EQUAL( decoder.position(), 4 );
+	TEST_EQUAL( decoder.errors(), 0 );
+
+	r = replay( decoder, BOUNCE_AT_DETENT, COUNT( BOUNCE_AT_DETENT ) );
+	TEST_EQUAL( r.steps, 1 );
+	TEST_EQUAL( r.detents, 1 );
+	TEST_EQUAL( decoder.position(), 4 );
+
+	// the rejected transition loses two quarter steps: three detents of
+	// edges give two detents of steps, and the count stays 2 behind
+	r = replay( decoder, SKIPPED_CW, COUNT( SKIPPED_CW ) );
+	TEST_EQUAL( decoder.errors(), 1 );
+	TEST_EQUAL( decoder.position(), 10 );
+	TEST_EQUAL( r.steps, 2 );
+
+	// 10 ms apart against the 60 ms reference: ( 60 / 10 )^2 = 36 steps
+	// from the second detent on; the reversal restarts at one step
+	r = replay( decoder, SPIN_CW, COUNT( SPIN_CW ) );
+	TEST_EQUAL( r.detents, 4 );
+	TEST_EQUAL( r.steps, 1 + 36 + 36 - 1 );
+	TEST_EQUAL( r.last, -1 );
+
+	// acceleration off: the same spin counts one step per detent
+	decoder.set_acceleration( 0, 1 );
+	r = replay( decoder, SPIN_CW, COUNT( SPIN_CW ) );
+	TEST_EQUAL( r.steps, 1 + 1 + 1 - 1 );
+
+	return test_report( "quadrature" );
+}
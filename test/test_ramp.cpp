@@ -0,0 +1,151 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * PwmDoubleRamp: one step per period for each target while the main
+ * context holds a PwmDoubleGroup open, a retarget that meets the interrupt
+ * of the last step, and the duty cycle and dephase of every channel through
+ * a period ramp there and back.
+ */
+#include "PwmDoubleOut.h"
+#include "PwmDoubleGroup.h"
+#include "PwmDoubleRamp.h"
+#include "pwm1_sim.h"
+#include "test.h"
+
+using namespace mbed;
+
+// Run to just past the next period start
+static void past_period_start() {
+	pwm1_sim_run( pwm1_sim_active( 0 ) - LPC_PWM1->TC + 1 );
+}
+
+// Each step reaches the match register 'match' one period after the last
+static void test_group( PwmDoubleOut& a, PwmDoubleRamp::Target target, int match,
+                        uint32_t to, uint32_t steps ) {
+	PwmDoubleRamp ramp( a, target );
+	past_period_start();
+	{
+		PwmDoubleGroup group;
+		TEST_EQUAL( ramp.start( to, steps ), 0 );
+		// step k is stored at the start of period k and latched at the next
+		pwm1_sim_run( pwm1_sim_active( 0 ) );
+		uint32_t last = pwm1_sim_active( match );
+		for ( uint32_t k = 0; k < steps; k++ ) {
+			pwm1_sim_run( pwm1_sim_active( 0 ) );
+			TEST_CHECK( pwm1_sim_active( match ) > last );
+			last = pwm1_sim_active( match );
+		}
+		TEST_EQUAL( last, to );
+		TEST_CHECK( !ramp.running() );
+		TEST_EQUAL( pwmdoubleout_group_mask, 0 );
+	}
+	TEST_CHECK( !pwm1_sim_irq_enabled() );
+}
+
+/*
+ * The interrupt carrying the last step is pending when start() retargets,
+ * so it is taken as start() masks it: the step lands and detaches the ramp,
+ * and start() has to attach it again from there.
+ */
+static void test_retarget( PwmDoubleOut& a ) {
+	PwmDoubleRamp ramp( a, PwmDoubleRamp::DUTY );
+	a.set_edges( 0, 0 );
+	pwm1_sim_run( 300 );
+	past_period_start();
+	TEST_EQUAL( ramp.start( 40, 4 ), 0 );
+	pwm1_sim_run( 3 * 100 );
+	pwm1_sim_irq_latency( 50 );
+	pwm1_sim_run( 100 );
+	TEST_EQUAL( a.read_width(), 30 );
+	TEST_CHECK( ramp.running() );
+	TEST_EQUAL( ramp.start( 80, 4 ), 0 );
+	pwm1_sim_irq_latency( 0 );
+	TEST_EQUAL( a.read_width(), 40 );
+	TEST_CHECK( ramp.running() );
+	TEST_CHECK( pwm1_sim_irq_enabled() );
+	// from the landed value: 50, 60, 70, 80
+	pwm1_sim_run( 2 * 100 );
+	TEST_EQUAL( pwm1_sim_active( 2 ), 50 );
+	pwm1_sim_run( 4 * 100 );
+	TEST_EQUAL( pwm1_sim_active( 2 ), 80 );
+	TEST_CHECK( !ramp.running() );
+	TEST_CHECK( !pwm1_sim_irq_enabled() );
+}
+
+// Ticks high in the next 'periods' periods of channel 'pwm'
+static uint32_t high_ticks( int pwm, uint32_t periods ) {
+	uint32_t high = 0;
+	for ( uint32_t t = 0; t < periods * pwm1_sim_active( 0 ); t++ ) {
+		high += pwm1_sim_output( pwm );
+		pwm1_sim_run( 1 );
+	}
+	return high;
+}
+
+/*
+ * 192 -> 384 in 192 steps and back. Every period latched on the way holds
+ * the quarter period rise and half period width of a, and a 30 tick pulse
+ * at 100 of 192 on b stays in proportion. Stepping from the last step's
+ * rounded edges, a ended at 25% duty on 384 and dead back at 192.
+ */
+static void test_period_round_trip( PwmDoubleOut& a, PwmDoubleOut& b ) {
+	PwmDoubleRamp ramp( a, PwmDoubleRamp::PERIOD );
+	a.set_freq( 192 );
+	a.set_edges( 48, 96 );
+	b.set_edges( 100, 30 );
+	pwm1_sim_run( 3 * 192 );
+	past_period_start();
+	const uint32_t to[] = { 384, 192 };
+	for ( int leg = 0; leg < 2; leg++ ) {
+		TEST_EQUAL( ramp.start( to[leg], 192 ), 0 );
+		while ( ramp.running() ) {
+			pwm1_sim_run( pwm1_sim_active( 0 ) );
+			uint32_t period = pwm1_sim_active( 0 );
+			TEST_EQUAL( pwm1_sim_active( 1 ), period / 4 );
+			TEST_EQUAL( pwm1_sim_active( 2 ), period / 4 + period / 2 );
+			TEST_EQUAL( pwm1_sim_active( 3 ), period * 100 / 192 );
+			TEST_EQUAL( pwm1_sim_active( 4 ), period * 100 / 192 + period * 30 / 192 );
+		}
+		pwm1_sim_run( 2 * to[leg] );
+		past_period_start();
+		TEST_EQUAL( high_ticks( 2, 2 ), to[leg] );
+		TEST_EQUAL( high_ticks( 4, 2 ), 2 * ( to[leg] * 30 / 192 ) );
+	}
+	TEST_EQUAL( a.read_dephase(), 48 );
+	TEST_EQUAL( a.read_width(), 96 );
+	TEST_EQUAL( pwm1_sim_active( 3 ), 100 );
+	TEST_EQUAL( pwm1_sim_active( 4 ), 130 );
+	TEST_CHECK( !pwm1_sim_irq_enabled() );
+}
+
+int main() {
+	pwm1_sim_reset();
+	PwmDoubleOut a( p25 ); // PWM1.2: rises on MR1, falls on MR2
+	PwmDoubleOut b( p23 ); // PWM1.4: rises on MR3, falls on MR4
+	a.set_freq( 100 );
+	a.set_edges( 0, 0 );
+	pwm1_sim_run( 300 );
+
+	test_group( a, PwmDoubleRamp::DUTY, 2, 50, 10 );
+	a.set_edges( 0, 10 );
+	test_group( a, PwmDoubleRamp::PHASE, 1, 40, 8 );
+	test_group( a, PwmDoubleRamp::PERIOD, 0, 200, 5 );
+	a.set_freq( 100 );
+	test_retarget( a );
+	test_period_round_trip( a, b );
+	return test_report( "ramp" );
+}
@@ -0,0 +1,124 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * Period interrupt slots and the sequencer: attach and detach bookkeeping,
+ * and one queued step reaching the outputs per period, also while the main
+ * context holds a PwmDoubleGroup open.
+ */
+#include "PwmDoubleOut.h"
+#include "PwmDoubleGroup.h"
+#include "PwmDoubleSequencer.h"
+#include "pwm1_sim.h"
+#include "test.h"
+
+using namespace mbed;
+
+static uint32_t calls[8];
+
+static void count( uintptr_t id ) {
+	calls[id]++;
+}
+
+static void detach_self( uintptr_t id ) {
+	calls[id]++;
+	pwmdoubleout_irq_detach( &detach_self, id );
+}
+
+static uint64_t high_since;
+static uint32_t widths[64];
+static uint32_t pulses;
+
+static void edge( int channel, int level, uint64_t pclk ) {
+	if ( channel != PWM_2 ) {
+		return;
+	}
+	if ( level ) {
+		high_since = pclk;
+	} else if ( pulses < 64 ) {
+		widths[pulses++] = ( uint32_t )( pclk - high_since );
+	}
+}
+
+static void test_slots() {
+	for ( uintptr_t id = 0; id < 6; id++ ) {
+		TEST_EQUAL( pwmdoubleout_irq_attach( &count, id ), 0 );
+	}
+	TEST_EQUAL( pwmdoubleout_irq_attach( &count, 6 ), -1 );
+	TEST_CHECK( pwm1_sim_irq_enabled() );
+	pwm1_sim_run( 3 * pwm1_sim_active( 0 ) );
+	for ( uintptr_t id = 0; id < 6; id++ ) {
+		TEST_CHECK( calls[id] >= 2 );
+		pwmdoubleout_irq_detach( &count, id );
+	}
+	TEST_CHECK( !pwm1_sim_irq_enabled() );
+	TEST_EQUAL( LPC_PWM1->MCR & 1, 0 );
+
+	// a handler leaving from the interrupt keeps the others running
+	TEST_EQUAL( pwmdoubleout_irq_attach( &detach_self, 7 ), 0 );
+	TEST_EQUAL( pwmdoubleout_irq_attach( &count, 0 ), 0 );
+	calls[0] = 0;
+	pwm1_sim_run( 3 * pwm1_sim_active( 0 ) );
+	TEST_EQUAL( calls[7], 1 );
+	TEST_CHECK( calls[0] >= 2 );
+	TEST_CHECK( pwm1_sim_irq_enabled() );
+	pwmdoubleout_irq_detach( &count, 0 );
+	TEST_CHECK( !pwm1_sim_irq_enabled() );
+}
+
+static void test_sequencer( PwmDoubleOut& a ) {
+	static PwmDoubleStep ring[16];
+	PwmDoubleSequencer seq( ring, 16 );
+	a.set_edges( 0, 5 );
+	a.set_freq( 100 );
+	pwm1_sim_run( 1000 );
+	for ( uint32_t k = 0; k < 16; k++ ) {
+		PwmDoubleStep step = { { 0, 0, 10 + k }, 1 << 2 };
+		TEST_CHECK( seq.push( step ) );
+	}
+	TEST_CHECK( !seq.push( ring[0] ) );
+	// run to just past a period start, then hold a group open throughout
+	pwm1_sim_run( 100 - LPC_PWM1->TC + 1 );
+	pwm1_sim_attach_edge( edge );
+	{
+		PwmDoubleGroup group;
+		TEST_EQUAL( seq.start(), 0 );
+		pwm1_sim_run( 20 * 100 );
+	}
+	seq.stop();
+	pwm1_sim_attach_edge( 0 );
+	TEST_EQUAL( seq.pending(), 0 );
+	TEST_EQUAL( seq.underruns(), 20 - 16 );
+	// the first fall ends the pulse already running; then one period of
+	// the old width while the first step is latched, then one step per period
+	TEST_CHECK( pulses >= 19 );
+	TEST_EQUAL( widths[1], 5 );
+	for ( uint32_t k = 0; k < 16; k++ ) {
+		TEST_EQUAL( widths[2 + k], 10 + k );
+	}
+	TEST_EQUAL( widths[18], 25 );
+	TEST_EQUAL( pwmdoubleout_width[PWM_2], 25 );
+}
+
+int main() {
+	pwm1_sim_reset();
+	PwmDoubleOut a( p25 );
+	a.set_freq( 50 );
+	pwm1_sim_run( 200 );
+
+	test_slots();
+	test_sequencer( a );
+	return test_report( "sequencer" );
+}
@@ -0,0 +1,102 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * StaticPwmDoubleOut against PwmDoubleOut: the same random setter sequence
+ * on one channel of each must leave the same edges in the cache and in the
+ * model's active match registers.
+ */
+#include <stdlib.h>
+#include "PwmDoubleOut.h"
+#include "StaticPwmDoubleOut.h"
+#include "PwmDoubleGroup.h"
+#include "pwm1_sim.h"
+#include "test.h"
+
+using namespace mbed;
+
+static void settle() {
+	for ( int i = 0; i < 2; i++ ) {
+		uint32_t period = pwm1_sim_active( 0 );
+		uint32_t tc = LPC_PWM1->TC;
+		pwm1_sim_run( ( period > tc ) ? period - tc : 1 );
+	}
+}
+
+int main() {
+	pwm1_sim_reset();
+	PwmDoubleOut dynamic( p25 );
+	StaticPwmDoubleOut<p23> fixed;
+	const int a = PWM_2;
+	const int b = StaticPwmDoubleOut<p23>::channel();
+	srand( 1 );
+
+	for ( int i = 0; i < 20000; i++ ) {
+		int op = rand() % 7;
+		int v = rand() % 400 - 10;
+		int w = rand() % 400 - 10;
+		PwmDoubleGroup* group = ( rand() % 4 == 0 ) ? new PwmDoubleGroup : 0;
+		switch ( op ) {
+		case 0:
+			dynamic.set_duty_cycle( v );
+			fixed.set_duty_cycle( v );
+			break;
+		case 1:
+			dynamic.set_dephase( v );
+			fixed.set_dephase( v );
+			break;
+		case 2:
+			dynamic.set_edges( v, w );
+			fixed.set_edges( v, w );
+			break;
+		case 3:
+			dynamic.write_q16( ( uint32_t )v << 8 );
+			fixed.write_q16( ( uint32_t )v << 8 );
+			break;
+		case 4:
+			dynamic.dephase_q16( ( uint32_t )v << 8 );
+			fixed.dephase_q16( ( uint32_t )v << 8 );
+			break;
+		case 5: {
+			// a bare MR0 load leaves rise edges beyond the new period
+			uint32_t match[7] = { ( uint32_t )( 1 + rand() % 300 ) };
+			pwmdoubleout_load_match( match, 1 << 0 );
+			break;
+		}
+		default:
+			if ( v & 1 ) {
+				fixed.set_freq( 1 + rand() % 300 );
+			} else {
+				fixed.retune( 1 + rand() % 300 );
+			}
+			break;
+		}
+		delete group;
+		TEST_EQUAL( pwmdoubleout_width[b], pwmdoubleout_width[a] );
+		TEST_EQUAL( pwmdoubleout_match[b - 1], pwmdoubleout_match[a - 1] );
+		TEST_EQUAL( pwmdoubleout_match[b], pwmdoubleout_match[a] );
+		TEST_EQUAL( fixed.read_q16(), dynamic.read_q16() );
+		if ( i % 16 == 0 ) {
+			settle();
+			TEST_EQUAL( pwm1_sim_active( b - 1 ), pwm1_sim_active( a - 1 ) );
+			TEST_EQUAL( pwm1_sim_active( b ), pwm1_sim_active( a ) );
+		}
+		if ( test_failures ) {
+			printf( "step %d op %d v %d w %d\n", i, op, v, w );
+			break;
+		}
+	}
+	return test_report( "static_pwm" );
+}
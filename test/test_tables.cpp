@@ -0,0 +1,135 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * Harmonic content of the duty tables. Each table is compared, entry by
+ * entry and bin by bin of its DFT, with the same waveform computed here in
+ * double precision with the C library sin(). Rounding to ticks moves an
+ * entry by at most half a tick, so a DFT amplitude by at most one tick.
+ */
+#include "PwmDoubleTables.h"
+#include "test.h"
+#include <math.h>
+
+using namespace mbed;
+
+static const double PI = 3.14159265358979323846;
+
+struct Spectrum {
+	double amplitude[64];
+	unsigned bins;
+};
+
+// One-sided amplitude spectrum of one cycle of x, in ticks
+static void spectrum( const double* x, unsigned n, Spectrum& s ) {
+	s.bins = n / 2;
+	for ( unsigned k = 0; k < s.bins; k++ ) {
+		double re = 0, im = 0;
+		for ( unsigned i = 0; i < n; i++ ) {
+			re += x[i] * cos( 2 * PI * k * i / n );
+			im -= x[i] * sin( 2 * PI * k * i / n );
+		}
+		s.amplitude[k] = sqrt( re * re + im * im ) / n * ( k ? 2 : 1 );
+	}
+}
+
+// Total harmonic distortion of bins 2 and up against the fundamental
+static double thd( const Spectrum& s ) {
+	double sum = 0;
+	for ( unsigned k = 2; k < s.bins; k++ ) {
+		sum += s.amplitude[k] * s.amplitude[k];
+	}
+	return sqrt( sum ) / s.amplitude[1];
+}
+
+static double spwm_reference( unsigned i, unsigned n, double ticks, double m ) {
+	return ticks * ( 0.5 + 0.5 * m * sin( 2 * PI * i / n ) );
+}
+
+static double svpwm_reference( unsigned i, unsigned n, double ticks, double m ) {
+	double a = sin( 2 * PI * i / n );
+	double b = sin( 2 * PI * i / n + 2 * PI * 2 / 3 );
+	double c = sin( 2 * PI * i / n + 2 * PI / 3 );
+	double offset = -( fmax( a, fmax( b, c ) ) + fmin( a, fmin( b, c ) ) ) / 2;
+	return ticks * ( 0.5 + m / sqrt( 3.0 ) * ( a + offset ) );
+}
+
+// Compare a table with its reference: entries within rounding, every DFT
+// bin within one tick, the fundamental at 'fundamental' ticks and the
+// distortion within max_thd of the reference. Phase to phase, where the
+// zero sequence injected by SVPWM cancels, only the fundamental is left.
+template<class Table>
+static void check( const char* name, double ( *reference )( unsigned, unsigned, double, double ),
+                   double ticks, double m, double fundamental, double max_thd ) {
+	const unsigned n = Table::size;
+	double table[96], model[96], line[96];
+	for ( unsigned i = 0; i < n; i++ ) {
+		table[i] = Table::duty[i];
+		model[i] = reference( i, n, ticks, m );
+		TEST_CHECK( fabs( table[i] - model[i] ) <= 0.5 + 1e-9 );
+		// phase A minus phase B, which PwmDoublePlayer reads 2N/3 ahead
+		line[i] = ( double )Table::duty[i] - Table::duty[( i + 2 * n / 3 ) % n];
+	}
+	Spectrum t, r, l;
+	spectrum( table, n, t );
+	spectrum( model, n, r );
+	spectrum( line, n, l );
+
+	TEST_CHECK( fabs( t.amplitude[0] - ticks / 2 ) <= 0.5 );
+	TEST_CHECK( fabs( t.amplitude[1] - fundamental ) <= 1.0 );
+	TEST_CHECK( fabs( r.amplitude[1] - fundamental ) <= 1e-6 * ticks );
+	for ( unsigned k = 1; k < t.bins; k++ ) {
+		TEST_CHECK( fabs( t.amplitude[k] - r.amplitude[k] ) <= 1.0 );
+	}
+	// line to line: the fundamental scaled by sqrt(3), no zero sequence
+	TEST_CHECK( fabs( l.amplitude[1] - sqrt( 3.0 ) * fundamental ) <= 2.0 );
+	for ( unsigned k = 2; k < l.bins; k++ ) {
+		TEST_CHECK( l.amplitude[k] <= 2.0 );
+	}
+	TEST_CHECK( thd( l ) <= max_thd );
+	TEST_CHECK( fabs( thd( t ) - thd( r ) ) <= max_thd );
+	printf( "%s: fundamental %.3f ticks (reference %.3f), third %.3f, THD %.4f%%, line THD %.4f%%\n",
+	        name, t.amplitude[1], r.amplitude[1], t.amplitude[3], 100 * thd( t ), 100 * thd( l ) );
+}
+
+int main() {
+	// SPWM: a pure sine of amplitude m/2 of the period
+	check<SpwmTable<96, 192> >( "spwm 96/192", spwm_reference, 192, 1.0, 96, 0.005 );
+	check<SpwmTable<96, 192, 500> >( "spwm 96/192 m=0.5", spwm_reference, 192, 0.5, 48, 0.01 );
+	check<SpwmTable<48, 1000, 900> >( "spwm 48/1000 m=0.9", spwm_reference, 1000, 0.9, 450, 0.001 );
+
+	// SVPWM: the fundamental is 2/sqrt(3) larger than SPWM at the same m
+	// and the phase carries triplen harmonics that cancel between phases
+	check<SvpwmTable<96, 192> >( "svpwm 96/192", svpwm_reference, 192, 1.0, 192 / sqrt( 3.0 ), 0.005 );
+	check<SvpwmTable<48, 1000, 900> >( "svpwm 48/1000 m=0.9", svpwm_reference, 1000, 0.9,
+	                                   900 / sqrt( 3.0 ), 0.001 );
+	{
+		typedef SvpwmTable<96, 192> Table;
+		double table[96];
+		for ( unsigned i = 0; i < Table::size; i++ ) {
+			table[i] = Table::duty[i];
+		}
+		Spectrum s;
+		spectrum( table, Table::size, s );
+		// min-max injection is close to a triangle of a quarter of the
+		// fundamental's peak, 8 / pi^2 / 4 = 0.203 of it at the third
+		// harmonic, with no even harmonics
+		TEST_CHECK( fabs( s.amplitude[3] / s.amplitude[1] - 0.203 ) <= 0.01 );
+		for ( unsigned k = 2; k < s.bins; k += 2 ) {
+			TEST_CHECK( s.amplitude[k] <= 1.0 );
+		}
+	}
+	return test_report( "tables" );
+}
@@ -0,0 +1,99 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * TextLCD on the HD44780 bus model: what printf(), putc() and the print
+ * helpers put in the panel's display RAM, and which writes the
+ * framebuffer saves.
+ */
+#include "TextLCD.h"
+#include "hd44780_sim.h"
+#include "test.h"
+
+static const uint8_t ROW[4] = { 0x00, 0x40, 0x14, 0x54 };
+
+static void check_row( int row, const char* expected ) {
+	char text[21];
+	hd44780_sim_read( ROW[row], text, 20 );
+	if ( strcmp( text, expected ) != 0 ) {
+		printf( "row %d is \"%s\", expected \"%s\"\n", row, text, expected );
+		test_failures++;
+	}
+}
+
+int main() {
+	hd44780_sim_attach( p15, p16, p17, p18, p19, p20 );
+	TextLCD lcd( p15, p16, p17, p18, p19, p20, TextLCD::LCD20x4 );
+
+	// the class example: printf alone reaches the panel
+	lcd.printf( "Hello World!\n" );
+	check_row( 0, "Hello World!        " );
+	check_row( 1, "                    " );
+
+	lcd.putc( '>' );
+	check_row( 1, ">                   " );
+
+	// unchanged cells are not sent again
+	uint32_t data = hd44780_sim_data();
+	lcd.locate( 0, 0 );
+	lcd.printf( "Hello World!" );
+	TEST_EQUAL( hd44780_sim_data() - data, 0 );
+	lcd.locate( 0, 0 );
+	lcd.printf( "Hello Wor1d!" );
+	TEST_EQUAL( hd44780_sim_data() - data, 1 );
+	check_row( 0, "Hello Wor1d!        " );
+
+	// characters above 0x7f compare equal whichever way they were written
+	lcd.locate( 19, 3 );
+	lcd.putc( 0xdf );
+	data = hd44780_sim_data();
+	lcd.locate( 19, 3 );
+	lcd.putc( 0xdf );
+	lcd.locate( 19, 3 );
+	lcd.printf( "\xdf" );
+	TEST_EQUAL( hd44780_sim_data() - data, 0 );
+
+	// the print helpers only fill the framebuffer until a flush
+	lcd.locate( 0, 2 );
+	lcd.printString( "dA:<" );
+	lcd.printInt( 96, 5 );
+	lcd.printString( ">=" );
+	lcd.printTenths( 96, 192, 4 );
+	lcd.printString( "%" );
+	check_row( 2, "                    " );
+	lcd.flush();
+	check_row( 2, "dA:<00096>=50.0%    " );
+
+	// moveCursor flushes and leaves the address counter on the cursor
+	lcd.locate( 0, 3 );
+	lcd.printString( "Fq:<" );
+	lcd.moveCursor( 8, 0 );
+	check_row( 3, "Fq:<               \xdf" );
+	TEST_EQUAL( hd44780_sim_address(), ROW[0] + 8 );
+
+	// asynchronous writes land once the timer interrupt has clocked them out
+	lcd.setAsync( 1 );
+	lcd.locate( 0, 1 );
+	lcd.printf( "async" );
+	TEST_CHECK( lcd.busy() );
+	check_row( 1, ">                   " );
+	while ( lcd.busy() ) {
+		mbed_sim_run_us( 1000 );
+	}
+	check_row( 1, "async               " );
+	lcd.setAsync( 0 );
+
+	return test_report( "textlcd" );
+}
@@ -0,0 +1,142 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * pwm1_vcd: a known waveform recorded to a temporary file, read back line
+ * by line against the header, the initial levels and every timestamp and
+ * value change, including two edges at the same time under one timestamp.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "pwmdoubleout_api.h"
+#include "pwm1_sim.h"
+#include "pwm1_vcd.h"
+#include "test.h"
+
+#define PCLK_HZ 24000000
+#define PERIOD  100
+
+static char expected[4096];
+static size_t expected_used;
+
+static void expect( const char* format, unsigned long long value ) {
+	expected_used += snprintf( expected + expected_used, sizeof( expected ) - expected_used,
+	                           format, value );
+}
+
+// ns at 24 MHz, rounded down as the recorder does
+static unsigned long long ns( uint64_t pclk ) {
+	return pclk * 125 / 3;
+}
+
+// The file against expected[], reporting the first line that differs
+static void check_file( const char* path ) {
+	FILE* file = fopen( path, "r" );
+	TEST_CHECK( file != NULL );
+	if ( !file ) {
+		return;
+	}
+	char line[128];
+	const char* want = expected;
+	int number = 0;
+	while ( fgets( line, sizeof( line ), file ) ) {
+		number++;
+		size_t length = strlen( line );
+		if ( strncmp( line, want, length ) != 0 ) {
+			const char* end = strchr( want, '\n' );
+			printf( "%s:%d: line %d is \"%.*s\", expected \"%.*s\"\n", __FILE__, __LINE__, number,
+			        ( int )length - 1, line, end ? ( int )( end - want ) : ( int )strlen( want ), want );
+			test_failures++;
+			break;
+		}
+		want += length;
+	}
+	TEST_EQUAL( *want, 0 );
+	fclose( file );
+}
+
+/*
+ * PWM1.2 high from 20 to 50 and PWM1.4 from 50 to 80 of each period: the
+ * PWM1.2 fall and the PWM1.4 rise share one timestamp.
+ */
+static void test_waveform( const char* path ) {
+	pwmdoubleout_t a, b;
+	pwmdoubleout_init( &a, p25 ); // PWM1.2: rises on MR1, falls on MR2
+	pwmdoubleout_init( &b, p23 ); // PWM1.4: rises on MR3, falls on MR4
+	pwmdoubleout_set_freq( NULL, PERIOD );
+	pwmdoubleout_set_edges( &a, 20, 30 );
+	pwmdoubleout_set_edges( &b, 50, 30 );
+	pwm1_sim_run( 3 * PERIOD );
+	// open at a period start, close 40 ticks into the third period
+	uint32_t periods = pwm1_sim_periods();
+	while ( pwm1_sim_periods() == periods ) {
+		pwm1_sim_run( 1 );
+	}
+	uint64_t start = pwm1_sim_now();
+
+	TEST_EQUAL( pwm1_vcd_open( path, PCLK_HZ ), 0 );
+	pwm1_sim_run( 2 * PERIOD + 40 );
+	pwm1_vcd_close();
+	TEST_EQUAL( pwm1_vcd_edges(), 2 * 4 + 1 );
+
+	expect( "$comment LPC1768 PWM1 model, PCLK %llu Hz $end\n", PCLK_HZ );
+	expect( "$timescale 1ns $end\n$scope module pwm1 $end\n", 0 );
+	for ( int n = 1; n <= 6; n++ ) {
+		expect( "$var wire 1 %llu ", n );
+		expect( "PWM1_%llu $end\n", n );
+	}
+	expect( "$upscope $end\n$enddefinitions $end\n", 0 );
+	expect( "#%llu\n$dumpvars\n", ns( start ) );
+	for ( int n = 1; n <= 6; n++ ) {
+		expect( "0%llu\n", n );
+	}
+	expect( "$end\n", 0 );
+	for ( int k = 0; k < 3; k++ ) {
+		uint64_t at = start + k * PERIOD;
+		expect( "#%llu\n12\n", ns( at + 20 ) );
+		if ( k == 2 ) {
+			break;
+		}
+		expect( "#%llu\n02\n14\n", ns( at + 50 ) );
+		expect( "#%llu\n04\n", ns( at + 80 ) );
+	}
+	// the end of the capture
+	expect( "#%llu\n", ns( start + 2 * PERIOD + 40 ) );
+	check_file( path );
+}
+
+static void test_open_errors( const char* path ) {
+	TEST_EQUAL( pwm1_vcd_open( path, 0 ), -1 );
+	TEST_EQUAL( pwm1_vcd_open( "/nonexistent/pwm.vcd", PCLK_HZ ), -1 );
+	// nothing to close, and the edge hook is left alone
+	pwm1_vcd_close();
+}
+
+int main( void ) {
+	char path[] = "/tmp/test_vcd_XXXXXX";
+	int fd = mkstemp( path );
+	TEST_CHECK( fd >= 0 );
+	close( fd );
+	pwm1_sim_reset();
+
+	test_waveform( path );
+	test_open_errors( path );
+	unlink( path );
+	return test_report( "vcd" );
+}